@@ -1,5 +1,14 @@
 #include <iostream>
 #include <utility> // for std::pair
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstdlib>
 
 template <typename Key, typename Value>
 class Map 
@@ -133,6 +142,20 @@ private:
         inorder(node->right);
     }
 
+    // Helper function to deep copy a subtree
+    Node* clone(const Node* node) const 
+    {
+        if (node == nullptr) 
+        {
+            return nullptr;
+        }
+
+        Node* copy = new Node(node->key, node->value);
+        copy->left = clone(node->left);
+        copy->right = clone(node->right);
+        return copy;
+    }
+
     // Helper function to delete all nodes
     void destroy(Node* node) 
     {
@@ -147,6 +170,20 @@ private:
 public:
     Map() : root(nullptr) {}
 
+    // Deep copy: every node of the source tree is duplicated
+    Map(const Map& other) : root(other.clone(other.root)) {}
+
+    Map& operator=(const Map& other) 
+    {
+        if (this != &other) 
+        {
+            Node* copy = other.clone(other.root);
+            destroy(root);
+            root = copy;
+        }
+        return *this;
+    }
+
     ~Map() 
     {
         destroy(root);
@@ -182,7 +219,352 @@ public:
     }
 };
 
-int main() {
+// Persistent (immutable, structurally shared) map.
+// Every insert/erase copies only the nodes on the path from the root to the
+// changed key (O(log n) thanks to AVL balancing) and returns a new version;
+// all untouched subtrees are shared with the previous version. Nodes are
+// reference counted through std::shared_ptr, so a version stays alive as long
+// as somebody holds it and is freed automatically once the last holder goes.
+// Nodes are never modified after construction, which makes any version safe
+// to read from several threads at once.
+// CountNodes enables the node counters used by the benchmark; they are
+// shared atomics, so ordinary maps keep them out of the hot path
+template <typename Key, typename Value, bool CountNodes = false>
+class PersistentMap 
+{
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node 
+    {
+        Key key;
+        Value value;
+        NodePtr left;
+        NodePtr right;
+        int height;
+        size_t size;
+
+        Node(const Key& k, const Value& v, NodePtr l, NodePtr r)
+            : key(k), value(v), left(std::move(l)), right(std::move(r)),
+              height(std::max(getHeight(left), getHeight(right)) + 1),
+              size(getSize(left) + getSize(right) + 1) 
+        {
+            if constexpr (CountNodes) 
+            {
+                liveNodes.fetch_add(1, std::memory_order_relaxed);
+                allocatedNodes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        ~Node() 
+        {
+            if constexpr (CountNodes) 
+            {
+                liveNodes.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    NodePtr root;
+
+    explicit PersistentMap(NodePtr r) : root(std::move(r)) {}
+
+    static int getHeight(const NodePtr& node) 
+    {
+        return node ? node->height : 0;
+    }
+
+    static size_t getSize(const NodePtr& node) 
+    {
+        return node ? node->size : 0;
+    }
+
+    static NodePtr makeNode(const Key& key, const Value& value, NodePtr left, NodePtr right) 
+    {
+        return std::make_shared<const Node>(key, value, std::move(left), std::move(right));
+    }
+
+    // Build a node from the given parts and restore the AVL property.
+    // Rotations allocate fresh nodes instead of relinking existing ones.
+    static NodePtr balance(const Key& key, const Value& value, NodePtr left, NodePtr right) 
+    {
+        int diff = getHeight(left) - getHeight(right);
+
+        if (diff > 1) 
+        {
+            if (getHeight(left->left) < getHeight(left->right)) 
+            {
+                // Left Right Case
+                const NodePtr& lr = left->right;
+                return makeNode(lr->key, lr->value,
+                                makeNode(left->key, left->value, left->left, lr->left),
+                                makeNode(key, value, lr->right, std::move(right)));
+            }
+            // Left Left Case
+            return makeNode(left->key, left->value, left->left,
+                            makeNode(key, value, left->right, std::move(right)));
+        }
+
+        if (diff < -1) 
+        {
+            if (getHeight(right->right) < getHeight(right->left)) 
+            {
+                // Right Left Case
+                const NodePtr& rl = right->left;
+                return makeNode(rl->key, rl->value,
+                                makeNode(key, value, std::move(left), rl->left),
+                                makeNode(right->key, right->value, rl->right, right->right));
+            }
+            // Right Right Case
+            return makeNode(right->key, right->value,
+                            makeNode(key, value, std::move(left), right->left),
+                            right->right);
+        }
+
+        return makeNode(key, value, std::move(left), std::move(right));
+    }
+
+    // Helper function to insert a key-value pair, copying the search path
+    static NodePtr insert(const NodePtr& node, const Key& key, const Value& value) 
+    {
+        if (!node) 
+        {
+            return makeNode(key, value, nullptr, nullptr);
+        }
+
+        if (key < node->key) 
+        {
+            return balance(node->key, node->value, insert(node->left, key, value), node->right);
+        }
+        else if (key > node->key) 
+        {
+            return balance(node->key, node->value, node->left, insert(node->right, key, value));
+        }
+        else 
+        {
+            // Key already exists, the new version gets the updated value
+            return makeNode(key, value, node->left, node->right);
+        }
+    }
+
+    // Helper function to detach the minimum node of a subtree
+    static NodePtr eraseMin(const NodePtr& node, const Node*& minNode) 
+    {
+        if (!node->left) 
+        {
+            minNode = node.get();
+            return node->right;
+        }
+        return balance(node->key, node->value, eraseMin(node->left, minNode), node->right);
+    }
+
+    // Helper function to erase a key, copying the search path
+    static NodePtr erase(const NodePtr& node, const Key& key, bool& erased) 
+    {
+        if (!node) 
+        {
+            return nullptr; // Key not found
+        }
+
+        if (key < node->key) 
+        {
+            NodePtr left = erase(node->left, key, erased);
+            return erased ? balance(node->key, node->value, std::move(left), node->right) : node;
+        }
+        else if (key > node->key) 
+        {
+            NodePtr right = erase(node->right, key, erased);
+            return erased ? balance(node->key, node->value, node->left, std::move(right)) : node;
+        }
+
+        erased = true;
+        if (!node->left) 
+        {
+            return node->right;
+        }
+        if (!node->right) 
+        {
+            return node->left;
+        }
+
+        const Node* successor = nullptr;
+        NodePtr right = eraseMin(node->right, successor);
+        return balance(successor->key, successor->value, node->left, std::move(right));
+    }
+
+    // Helper function for in-order traversal
+    static void inorder(const NodePtr& node) 
+    {
+        if (!node) 
+        {
+            return;
+        }
+
+        inorder(node->left);
+        std::cout << node->key << ": " << node->value << std::endl;
+        inorder(node->right);
+    }
+
+public:
+    // Node counters used by the benchmark to report memory usage (CountNodes only)
+    static std::atomic<size_t> liveNodes;
+    static std::atomic<size_t> allocatedNodes;
+
+    PersistentMap() = default;
+
+    // Return a new version containing the key-value pair
+    PersistentMap insert(const Key& key, const Value& value) const 
+    {
+        return PersistentMap(insert(root, key, value));
+    }
+
+    // Return a new version without the key (shares everything if absent)
+    PersistentMap erase(const Key& key) const 
+    {
+        bool erased = false;
+        NodePtr newRoot = erase(root, key, erased);
+        return erased ? PersistentMap(std::move(newRoot)) : *this;
+    }
+
+    // O(1) point-in-time copy: only the root reference count is bumped
+    PersistentMap snapshot() const 
+    {
+        return *this;
+    }
+
+    // Find the value associated with a key in this version
+    const Value* find(const Key& key) const 
+    {
+        const Node* node = root.get();
+        while (node) 
+        {
+            if (key < node->key) 
+            {
+                node = node->left.get();
+            }
+            else if (key > node->key) 
+            {
+                node = node->right.get();
+            }
+            else 
+            {
+                return &node->value;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const 
+    {
+        return getSize(root);
+    }
+
+    // Approximate heap footprint of one node (payload + shared_ptr control block)
+    static size_t nodeBytes() 
+    {
+        return sizeof(Node) + 2 * sizeof(long);
+    }
+
+    // Print all key-value pairs (in-order traversal)
+    void print() const 
+    {
+        inorder(root);
+    }
+};
+
+template <typename Key, typename Value, bool CountNodes>
+std::atomic<size_t> PersistentMap<Key, Value, CountNodes>::liveNodes{0};
+
+template <typename Key, typename Value, bool CountNodes>
+std::atomic<size_t> PersistentMap<Key, Value, CountNodes>::allocatedNodes{0};
+
+// Benchmark: take a snapshot after every update, once with deep copies of Map
+// and once with PersistentMap versions. Keys are inserted in shuffled order so
+// the unbalanced Map keeps a reasonable depth.
+void benchmarkSnapshots(int n, int updates) 
+{
+    using namespace std::chrono;
+
+    if (n <= 0 || updates <= 0) 
+    {
+        std::cout << "\nSnapshot benchmark needs at least one key and one update" << std::endl;
+        return;
+    }
+
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; ++i) 
+    {
+        keys[i] = i;
+    }
+    std::mt19937 rng(42);
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    // Keys updated in each round, drawn uniformly from the whole tree
+    std::vector<int> updated(updates);
+    for (int i = 0; i < updates; ++i) 
+    {
+        updated[i] = keys[rng() % n];
+    }
+
+    std::cout << "\nSnapshot benchmark: " << n << " keys, " << updates << " update+snapshot rounds" << std::endl;
+
+    {
+        Map<int, int> base;
+        for (int k : keys) 
+        {
+            base.insert(k, k);
+        }
+
+        auto start = high_resolution_clock::now();
+        for (int i = 0; i < updates; ++i) 
+        {
+            base.insert(updated[i], -i);
+            Map<int, int> copy(base); // deep copy snapshot
+            if (copy.find(updated[i]) == nullptr) 
+            {
+                std::cout << "deep copy lost a key!" << std::endl;
+            }
+        }
+        auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        size_t nodeBytes = sizeof(int) * 2 + sizeof(void*) * 2; // Map<int,int>::Node
+        std::cout << "Deep copy  : " << elapsed / updates << " us per snapshot, "
+                  << nodeBytes * n / 1024 << " KiB copied per snapshot" << std::endl;
+    }
+
+    {
+        using PMap = PersistentMap<int, int, true>;
+        PMap current;
+        for (int k : keys) 
+        {
+            current = current.insert(k, k);
+        }
+
+        std::vector<PMap> history;
+        history.reserve(updates);
+        size_t liveBefore = PMap::liveNodes;
+        size_t allocatedBefore = PMap::allocatedNodes;
+
+        auto start = high_resolution_clock::now();
+        for (int i = 0; i < updates; ++i) 
+        {
+            current = current.insert(updated[i], -i);
+            history.push_back(current.snapshot());
+        }
+        auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+
+        size_t perUpdate = (PMap::allocatedNodes - allocatedBefore) / updates;
+        std::cout << "Persistent : " << elapsed / updates << " ns per update+snapshot, "
+                  << perUpdate << " nodes (~" << perUpdate * PMap::nodeBytes()
+                  << " B) copied per update" << std::endl;
+        std::cout << "Persistent : " << updates << " retained versions hold "
+                  << (PMap::liveNodes - liveBefore) << " extra nodes (deep copies would hold "
+                  << static_cast<size_t>(n) * updates << ")" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
     Map<int, std::string> myMap;
 
     myMap.insert(10, "ten");
@@ -201,6 +583,41 @@ int main() {
     std::cout << "\nAfter erasing 10:" << std::endl;
     myMap.print();
 
+    // Persistent map: older versions stay readable after updates
+    PersistentMap<int, std::string> v1 = PersistentMap<int, std::string>()
+        .insert(10, "ten").insert(20, "twenty").insert(5, "five");
+    PersistentMap<int, std::string> snap = v1.snapshot();
+    PersistentMap<int, std::string> v2 = v1.erase(20).insert(15, "fifteen");
+
+    // A reader thread walks the old snapshot while the writer keeps producing versions
+    std::thread reader([&snap]() {
+        for (int i = 0; i < 1000; ++i) 
+        {
+            if (snap.find(20) == nullptr || snap.find(15) != nullptr) 
+            {
+                std::cout << "snapshot changed!" << std::endl;
+                return;
+            }
+        }
+    });
+    for (int i = 0; i < 1000; ++i) 
+    {
+        v2 = v2.insert(100 + i, "x").erase(100 + i);
+    }
+    reader.join();
+
+    std::cout << "\nSnapshot (before erasing 20):" << std::endl;
+    snap.print();
+    std::cout << "\nLatest version:" << std::endl;
+    v2.print();
+
+    // Run "./map bench [keys] [updates]" for the snapshot benchmark
+    if (argc > 1 && std::string(argv[1]) == "bench") 
+    {
+        int n = argc > 2 ? std::atoi(argv[2]) : 100000;
+        int updates = argc > 3 ? std::atoi(argv[3]) : 200;
+        benchmarkSnapshots(n, updates);
+    }
+
     return 0;
 }
-
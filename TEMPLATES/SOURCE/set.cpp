@@ -1,6 +1,15 @@
 #include <iostream>
 #include <memory>
 #include <algorithm> // For std::max
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <cmath>
+#include <iterator>
 
 template <typename T>
 class MySet 
@@ -12,18 +21,35 @@ class MySet
         std::unique_ptr<Node> left;
         std::unique_ptr<Node> right;
         int height;
+        size_t size; // Number of nodes in this subtree (order-statistics augmentation)
 
-        Node(const T& val) : value(val), left(nullptr), right(nullptr), height(1) {}
+        Node(const T& val) : value(val), left(nullptr), right(nullptr), height(1), size(1) {}
     };
 
     std::unique_ptr<Node> root;
 
+    // Upper bound on AVL height (1.44 * log2(n)) for any n that fits in memory
+    static const int MAX_HEIGHT = 96;
+
     // Get height of a node
     int getHeight(const std::unique_ptr<Node>& node) const 
     {
         return node ? node->height : 0;
     }
 
+    // Get subtree size of a node
+    size_t getSize(const std::unique_ptr<Node>& node) const 
+    {
+        return node ? node->size : 0;
+    }
+
+    // Recompute height and subtree size from the children
+    void update(Node* node) 
+    {
+        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        node->size = getSize(node->left) + getSize(node->right) + 1;
+    }
+
     // Calculate balance factor of a node
     int getBalanceFactor(const std::unique_ptr<Node>& node) const 
     {
@@ -39,9 +65,9 @@ class MySet
         x->right = std::move(y);
         x->right->left = std::move(T2);
 
-        // Update heights
-        x->right->height = std::max(getHeight(x->right->left), getHeight(x->right->right)) + 1;
-        x->height = std::max(getHeight(x->left), getHeight(x->right)) + 1;
+        // Update heights and subtree sizes
+        update(x->right.get());
+        update(x.get());
 
         return x;
     }
@@ -55,9 +81,9 @@ class MySet
         y->left = std::move(x);
         y->left->right = std::move(T2);
 
-        // Update heights
-        y->left->height = std::max(getHeight(y->left->left), getHeight(y->left->right)) + 1;
-        y->height = std::max(getHeight(y->left), getHeight(y->right)) + 1;
+        // Update heights and subtree sizes
+        update(y->left.get());
+        update(y.get());
 
         return y;
     }
@@ -86,8 +112,8 @@ class MySet
             return node;
         }
 
-        // Update height of the current node
-        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        // Update height and size of the current node
+        update(node.get());
 
         // Balance the node
         int balance = getBalanceFactor(node);
@@ -163,8 +189,8 @@ class MySet
 
         if (!node) return nullptr;
 
-        // Update height
-        node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+        // Update height and size
+        update(node.get());
 
         // Balance the node
         int balance = getBalanceFactor(node);
@@ -194,6 +220,156 @@ class MySet
         return node;
     }
 
+    // In-order traversal calling func on each value
+    template <typename Func>
+    void forEachHelper(const std::unique_ptr<Node>& node, Func& func) const 
+    {
+        if (!node) return;
+
+        forEachHelper(node->left, func);
+        func(node->value);
+        forEachHelper(node->right, func);
+    }
+
+    enum class SetOp { Union, Intersection, Difference };
+
+    // One side of a merge: an in-order cursor that stops at an optional
+    // exclusive upper bound (used to cut the inputs into parallel chunks)
+    struct MergeRange 
+    {
+        typename MySet::const_iterator it;
+        typename MySet::const_iterator end;
+        const T* upper;
+
+        bool done() const { return it == end || (upper && !(*it < *upper)); }
+    };
+
+    // Linear merge of two sorted ranges, appending the result of op to out
+    static void mergeRanges(MergeRange a, MergeRange b, SetOp op, std::vector<T>& out) 
+    {
+        while (!a.done() && !b.done()) 
+        {
+            if (*a.it < *b.it) 
+            {
+                if (op != SetOp::Intersection) out.push_back(*a.it);
+                ++a.it;
+            }
+            else if (*b.it < *a.it) 
+            {
+                if (op == SetOp::Union) out.push_back(*b.it);
+                ++b.it;
+            }
+            else 
+            {
+                if (op != SetOp::Difference) out.push_back(*a.it);
+                ++a.it;
+                ++b.it;
+            }
+        }
+        for (; op != SetOp::Intersection && !a.done(); ++a.it) out.push_back(*a.it);
+        for (; op == SetOp::Union && !b.done(); ++b.it) out.push_back(*b.it);
+    }
+
+    // Build a perfectly balanced subtree from sorted[lo, hi) in O(hi - lo)
+    static std::unique_ptr<Node> buildBalanced(const std::vector<T>& sorted, size_t lo, size_t hi) 
+    {
+        if (lo >= hi) return nullptr;
+
+        size_t mid = lo + (hi - lo) / 2;
+        auto node = std::make_unique<Node>(sorted[mid]);
+        node->left = buildBalanced(sorted, lo, mid);
+        node->right = buildBalanced(sorted, mid + 1, hi);
+        node->height = std::max(node->left ? node->left->height : 0,
+                                node->right ? node->right->height : 0) + 1;
+        node->size = hi - lo;
+        return node;
+    }
+
+    static MySet fromSorted(const std::vector<T>& sorted) 
+    {
+        MySet result;
+        result.root = buildBalanced(sorted, 0, sorted.size());
+        return result;
+    }
+
+    // Probing each element of a small set in a big one visits m*log(n) nodes,
+    // the merge visits every node about twice (iterator descent + ascent);
+    // probe when that is cheaper, giving O(min(n + m, m log n)) overall
+    static bool preferProbing(size_t small, size_t big) 
+    {
+        return small * (std::log2(static_cast<double>(big) + 1) + 1) < 2.0 * (small + big);
+    }
+
+    // Merge this set with other, splitting the key space into chunks at
+    // evenly spaced elements (via select) of the larger input
+    std::vector<T> merge(const MySet& other, SetOp op, unsigned threads) const 
+    {
+        const MySet& larger = size() >= other.size() ? *this : other;
+        size_t chunks = std::max(1u, threads);
+        if (larger.size() < chunks * 4096) chunks = 1; // not worth a thread
+
+        std::vector<const T*> bounds(chunks + 1, nullptr);
+        for (size_t c = 1; c < chunks; ++c) 
+        {
+            bounds[c] = larger.select(c * larger.size() / chunks);
+        }
+
+        std::vector<std::vector<T>> parts(chunks);
+        auto work = [&](size_t c) {
+            MergeRange a{ bounds[c] ? lower_bound(*bounds[c]) : begin(), end(), bounds[c + 1] };
+            MergeRange b{ bounds[c] ? other.lower_bound(*bounds[c]) : other.begin(), other.end(), bounds[c + 1] };
+            mergeRanges(a, b, op, parts[c]);
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t c = 1; c < chunks; ++c) 
+        {
+            workers.emplace_back(work, c);
+        }
+        work(0);
+        for (auto& worker : workers) 
+        {
+            worker.join();
+        }
+
+        if (chunks == 1) return std::move(parts[0]);
+
+        std::vector<T> result;
+        size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        result.reserve(total);
+        for (auto& part : parts) 
+        {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        return result;
+    }
+
+    // Restore the AVL property at *slot after one of its subtrees changed.
+    // The link is only rewritten when a rotation is actually needed.
+    void rebalance(std::unique_ptr<Node>& slot) 
+    {
+        Node* node = slot.get();
+        int balance = getBalanceFactor(slot);
+
+        if (balance > 1) 
+        {
+            // Left Right Case
+            if (getBalanceFactor(node->left) < 0)
+                node->left = rotateLeft(std::move(node->left));
+            // Left Left Case
+            slot = rotateRight(std::move(slot));
+        }
+        else if (balance < -1) 
+        {
+            // Right Left Case
+            if (getBalanceFactor(node->right) > 0)
+                node->right = rotateRight(std::move(node->right));
+            // Right Right Case
+            slot = rotateLeft(std::move(slot));
+        }
+    }
+
     // In-order traversal
     void inOrderTraversal(const std::unique_ptr<Node>& node) const 
     {
@@ -205,24 +381,233 @@ class MySet
     }
 
 public:
+    // Forward iterator over the values in sorted order. It keeps the stack of
+    // ancestors whose value is still to be visited, so no parent pointers are
+    // needed. Any insert/erase invalidates all iterators.
+    class const_iterator 
+    {
+    private:
+        std::vector<const Node*> stack;
+
+        void pushLeftSpine(const Node* node) 
+        {
+            while (node) 
+            {
+                stack.push_back(node);
+                node = node->left.get();
+            }
+        }
+
+        friend class MySet;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const T& operator*() const { return stack.back()->value; }
+        const T* operator->() const { return &stack.back()->value; }
+
+        const_iterator& operator++() 
+        {
+            const Node* node = stack.back();
+            stack.pop_back();
+            pushLeftSpine(node->right.get());
+            return *this;
+        }
+
+        const_iterator operator++(int) 
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const 
+        {
+            if (stack.empty() || other.stack.empty()) 
+                return stack.empty() == other.stack.empty();
+            return stack.back() == other.stack.back();
+        }
+
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    using iterator = const_iterator; // values are immutable, as in std::set
+
     MySet() : root(nullptr) {}
 
-    // Insert a value
+    // Insert a value (iterative: walk down recording the links, then fix
+    // sizes/heights bottom-up; only rotated links are rewritten)
     bool insert(const T& value) 
+    {
+        std::unique_ptr<Node>* path[MAX_HEIGHT];
+        int depth = 0;
+
+        std::unique_ptr<Node>* slot = &root;
+        while (*slot) 
+        {
+            Node* node = slot->get();
+            path[depth++] = slot;
+            if (value < node->value) 
+            {
+                slot = &node->left;
+            }
+            else if (value > node->value) 
+            {
+                slot = &node->right;
+            }
+            else 
+            {
+                // Duplicate values are not allowed
+                return false;
+            }
+        }
+        *slot = std::make_unique<Node>(value);
+
+        // Heights can only change until the first node whose height stays the
+        // same (or which gets rotated); above it only sizes grow by one
+        bool heightChanged = true;
+        while (depth > 0) 
+        {
+            std::unique_ptr<Node>& link = *path[--depth];
+            Node* node = link.get();
+            node->size++;
+            if (!heightChanged) continue;
+
+            int oldHeight = node->height;
+            node->height = std::max(getHeight(node->left), getHeight(node->right)) + 1;
+            if (node->height == oldHeight) 
+            {
+                heightChanged = false;
+            }
+            else if (std::abs(getBalanceFactor(link)) > 1) 
+            {
+                rebalance(link);
+                heightChanged = false;
+            }
+        }
+        return true;
+    }
+
+    // Erase a value (iterative counterpart of eraseHelper)
+    bool erase(const T& value) 
+    {
+        std::unique_ptr<Node>* path[MAX_HEIGHT];
+        int depth = 0;
+
+        std::unique_ptr<Node>* slot = &root;
+        while (*slot && (value < (*slot)->value || value > (*slot)->value)) 
+        {
+            path[depth++] = slot;
+            slot = value < (*slot)->value ? &(*slot)->left : &(*slot)->right;
+        }
+        if (!*slot) 
+        {
+            return false; // Value not found
+        }
+
+        Node* target = slot->get();
+        if (target->left && target->right) 
+        {
+            // Replace the value by the in-order successor and unlink that node instead
+            path[depth++] = slot;
+            slot = &target->right;
+            while ((*slot)->left) 
+            {
+                path[depth++] = slot;
+                slot = &(*slot)->left;
+            }
+            target->value = std::move((*slot)->value);
+        }
+
+        // The node at *slot has at most one child: splice it out
+        *slot = std::move((*slot)->left ? (*slot)->left : (*slot)->right);
+
+        while (depth > 0) 
+        {
+            std::unique_ptr<Node>& link = *path[--depth];
+            update(link.get());
+            rebalance(link);
+        }
+        return true;
+    }
+
+    // Reference recursive implementations, kept to benchmark the iterative ones
+    bool insertRecursive(const T& value) 
     {
         bool inserted = false;
         root = insertHelper(std::move(root), value, inserted);
         return inserted;
     }
 
-    // Erase a value
-    bool erase(const T& value) 
+    bool eraseRecursive(const T& value) 
     {
         bool erased = false;
         root = eraseHelper(std::move(root), value, erased);
         return erased;
     }
 
+    const_iterator begin() const 
+    {
+        const_iterator it;
+        it.pushLeftSpine(root.get());
+        return it;
+    }
+
+    const_iterator end() const 
+    {
+        return const_iterator();
+    }
+
+    // Iterator to value, or end() if it is not in the set
+    const_iterator find(const T& value) const 
+    {
+        const_iterator it;
+        const Node* current = root.get();
+        while (current) 
+        {
+            if (value < current->value) 
+            {
+                // current is still ahead of value in sorted order
+                it.stack.push_back(current);
+                current = current->left.get();
+            }
+            else if (value > current->value) 
+            {
+                current = current->right.get();
+            }
+            else 
+            {
+                it.stack.push_back(current);
+                return it;
+            }
+        }
+        return end();
+    }
+
+    // Iterator to the first value not less than value, or end()
+    const_iterator lower_bound(const T& value) const 
+    {
+        const_iterator it;
+        const Node* current = root.get();
+        while (current) 
+        {
+            if (current->value < value) 
+            {
+                current = current->right.get();
+            }
+            else 
+            {
+                it.stack.push_back(current);
+                current = current->left.get();
+            }
+        }
+        return it;
+    }
+
     // Check if a value exists
     bool contains(const T& value) const 
     {
@@ -245,6 +630,140 @@ public:
         return false;
     }
 
+    // Number of elements in the set
+    size_t size() const 
+    {
+        return getSize(root);
+    }
+
+    // Number of elements strictly less than value, O(log n)
+    size_t count_less(const T& value) const 
+    {
+        size_t count = 0;
+        Node* current = root.get();
+        while (current) 
+        {
+            if (current->value < value) 
+            {
+                count += getSize(current->left) + 1;
+                current = current->right.get();
+            }
+            else 
+            {
+                current = current->left.get();
+            }
+        }
+        return count;
+    }
+
+    // Number of elements in the closed range [lo, hi], O(log n)
+    size_t count_in_range(const T& lo, const T& hi) const 
+    {
+        if (hi < lo) return 0;
+        size_t upto = count_less(hi) + (contains(hi) ? 1 : 0);
+        return upto - count_less(lo);
+    }
+
+    // Zero-based position of value in sorted order, or -1 if it is absent
+    long rank(const T& value) const 
+    {
+        return contains(value) ? static_cast<long>(count_less(value)) : -1;
+    }
+
+    // k-th smallest element (zero-based), or nullptr if k >= size(), O(log n)
+    const T* select(size_t k) const 
+    {
+        Node* current = root.get();
+        while (current) 
+        {
+            size_t leftSize = getSize(current->left);
+            if (k < leftSize) 
+            {
+                current = current->left.get();
+            }
+            else if (k == leftSize) 
+            {
+                return &current->value;
+            }
+            else 
+            {
+                k -= leftSize + 1;
+                current = current->right.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Set algebra. Both trees are walked in order and the sorted result is
+    // turned back into a balanced tree, so each call is O(n + m). With
+    // threads > 1 large inputs are split into value ranges merged in parallel.
+    MySet set_union(const MySet& other, unsigned threads = 1) const 
+    {
+        return fromSorted(merge(other, SetOp::Union, threads));
+    }
+
+    MySet set_intersection(const MySet& other, unsigned threads = 1) const 
+    {
+        const MySet& small = size() <= other.size() ? *this : other;
+        const MySet& big = size() <= other.size() ? other : *this;
+        if (preferProbing(small.size(), big.size())) 
+        {
+            std::vector<T> result;
+            for (const T& value : small) 
+            {
+                if (big.contains(value)) result.push_back(value);
+            }
+            return fromSorted(result);
+        }
+        return fromSorted(merge(other, SetOp::Intersection, threads));
+    }
+
+    MySet set_difference(const MySet& other, unsigned threads = 1) const 
+    {
+        if (preferProbing(size(), other.size())) 
+        {
+            std::vector<T> result;
+            for (const T& value : *this) 
+            {
+                if (!other.contains(value)) result.push_back(value);
+            }
+            return fromSorted(result);
+        }
+        return fromSorted(merge(other, SetOp::Difference, threads));
+    }
+
+    // True if every element of this set is also in other
+    bool is_subset(const MySet& other) const 
+    {
+        if (size() > other.size()) return false;
+        if (preferProbing(size(), other.size())) 
+        {
+            for (const T& value : *this) 
+            {
+                if (!other.contains(value)) return false;
+            }
+            return true;
+        }
+
+        auto a = begin();
+        auto b = other.begin();
+        while (a != end()) 
+        {
+            while (b != other.end() && *b < *a) ++b;
+            if (b == other.end() || *a < *b) return false;
+            ++a;
+            ++b;
+        }
+        return true;
+    }
+
+    // Visit every element in sorted order
+    template <typename Func>
+    void forEach(Func func) const 
+    {
+        forEachHelper(root, func);
+    }
+
     // Display the set (in-order traversal)
     void display() const 
     {
@@ -253,7 +772,339 @@ public:
     }
 };
 
-int main() 
+// Sorted-vector alternative to MySet for small, read-mostly sets. Values
+// live in one contiguous array, so contains() touches a handful of cache
+// lines instead of chasing node pointers, at the cost of O(n) single inserts
+// and erases. Bulk loads should go through insert_range, which sorts the new
+// values and merges them into the array once.
+template <typename T>
+class MyFlatSet 
+{
+private:
+    std::vector<T> data; // Sorted, no duplicates
+
+    // Branchless lower bound: the loop has a fixed trip count of log2(n) and
+    // the comparison result is used arithmetically, so there is no branch to
+    // mispredict (a ternary here was compiled into a jump by g++)
+    size_t lowerBound(const T& value) const 
+    {
+        size_t len = data.size();
+        if (len == 0) return 0;
+
+        const T* base = data.data();
+        while (len > 1) 
+        {
+            size_t half = len / 2;
+            base += (base[half - 1] < value) * half;
+            len -= half;
+        }
+        return (base - data.data()) + (*base < value ? 1 : 0);
+    }
+
+public:
+    MyFlatSet() {}
+
+    // Insert a value
+    bool insert(const T& value) 
+    {
+        size_t pos = lowerBound(value);
+        if (pos < data.size() && !(value < data[pos])) 
+        {
+            // Duplicate values are not allowed
+            return false;
+        }
+        data.insert(data.begin() + pos, value);
+        return true;
+    }
+
+    // Insert a batch of values with one sort and one merge
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last) 
+    {
+        size_t oldSize = data.size();
+        data.insert(data.end(), first, last);
+        std::sort(data.begin() + oldSize, data.end());
+        std::inplace_merge(data.begin(), data.begin() + oldSize, data.end());
+        data.erase(std::unique(data.begin(), data.end(),
+                               [](const T& a, const T& b) { return !(a < b) && !(b < a); }),
+                   data.end());
+    }
+
+    // Erase a value
+    bool erase(const T& value) 
+    {
+        size_t pos = lowerBound(value);
+        if (pos == data.size() || value < data[pos]) 
+        {
+            return false; // Value not found
+        }
+        data.erase(data.begin() + pos);
+        return true;
+    }
+
+    // Check if a value exists
+    bool contains(const T& value) const 
+    {
+        size_t pos = lowerBound(value);
+        return pos < data.size() && !(value < data[pos]);
+    }
+
+    size_t size() const 
+    {
+        return data.size();
+    }
+
+    // Display the set
+    void display() const 
+    {
+        for (const T& value : data) 
+        {
+            std::cout << value << " ";
+        }
+        std::cout << std::endl;
+    }
+};
+
+// Benchmark: single-insert and lookup cost at growing sizes. The crossover
+// is the first size at which a read-mostly workload (16 lookups per insert)
+// runs faster on the AVL tree than on the flat set.
+void benchmarkFlatCrossover(size_t maxSize) 
+{
+    using namespace std::chrono;
+
+    auto nsPerOp = [](high_resolution_clock::time_point start, size_t ops) {
+        return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / double(ops);
+    };
+
+    std::cout << "\nFlat set vs AVL (ns per operation)" << std::endl;
+    size_t crossover = 0;
+    size_t insertCrossover = 0;
+    for (size_t n = 16; n <= maxSize; n *= 2) 
+    {
+        std::mt19937 rng(static_cast<unsigned>(n));
+        std::vector<int> values(n);
+        for (auto& v : values) 
+        {
+            v = static_cast<int>(rng() % (n * 4));
+        }
+        // Many distinct probes so the branch predictor cannot learn them
+        std::vector<int> probes(1 << 18);
+        for (auto& p : probes) 
+        {
+            p = static_cast<int>(rng() % (n * 4));
+        }
+
+        // Repeat small sizes so each insert measurement covers enough work
+        size_t rounds = std::max<size_t>(1, (1 << 16) / n);
+        long hits = 0;
+
+        auto start = high_resolution_clock::now();
+        for (size_t r = 0; r < rounds; ++r) 
+        {
+            MySet<int> tree;
+            for (int v : values) tree.insert(v);
+        }
+        double treeInsert = nsPerOp(start, rounds * n);
+
+        start = high_resolution_clock::now();
+        for (size_t r = 0; r < rounds; ++r) 
+        {
+            MyFlatSet<int> flat;
+            for (int v : values) flat.insert(v);
+        }
+        double flatInsert = nsPerOp(start, rounds * n);
+
+        start = high_resolution_clock::now();
+        for (size_t r = 0; r < rounds; ++r) 
+        {
+            MyFlatSet<int> flat;
+            flat.insert_range(values.begin(), values.end());
+        }
+        double batchInsert = nsPerOp(start, rounds * n);
+
+        MySet<int> tree;
+        MyFlatSet<int> flat;
+        for (int v : values) tree.insert(v);
+        flat.insert_range(values.begin(), values.end());
+
+        start = high_resolution_clock::now();
+        for (int p : probes) hits += tree.contains(p);
+        double treeLookup = nsPerOp(start, probes.size());
+
+        start = high_resolution_clock::now();
+        for (int p : probes) hits -= flat.contains(p);
+        double flatLookup = nsPerOp(start, probes.size());
+
+        if (crossover == 0 && treeInsert + 16 * treeLookup < flatInsert + 16 * flatLookup) 
+        {
+            crossover = n;
+        }
+        if (insertCrossover == 0 && treeInsert < flatInsert) 
+        {
+            insertCrossover = n;
+        }
+        std::cout << "n=" << n << ": insert AVL " << treeInsert << " / flat " << flatInsert
+                  << " / insert_range " << batchInsert << ", contains AVL " << treeLookup
+                  << " / flat " << flatLookup << (hits ? " (lookup mismatch!)" : "") << std::endl;
+    }
+
+    if (insertCrossover) 
+        std::cout << "Single inserts are cheaper in the AVL tree from n=" << insertCrossover << std::endl;
+    if (crossover) 
+        std::cout << "AVL wins the read-mostly mix from n=" << crossover << std::endl;
+    else 
+        std::cout << "Flat set wins the read-mostly mix at every measured size" << std::endl;
+}
+
+// Benchmark: p50/p99 percentile queries via select() versus an in-order walk
+void benchmarkPercentiles(size_t n) 
+{
+    using namespace std::chrono;
+
+    if (n == 0) 
+    {
+        std::cout << "\nPercentile benchmark needs at least one value" << std::endl;
+        return;
+    }
+
+    MySet<long> values;
+    std::mt19937_64 rng(42);
+    while (values.size() < n) 
+    {
+        values.insert(static_cast<long>(rng() % (n * 10)));
+    }
+
+    const size_t ranks[] = { n / 2, n * 99 / 100 };
+    const char* names[] = { "p50", "p99" };
+
+    std::cout << "\nPercentile benchmark over " << n << " values" << std::endl;
+    for (int q = 0; q < 2; ++q) 
+    {
+        const int queries = 100000;
+        long sink = 0;
+        auto start = high_resolution_clock::now();
+        for (int i = 0; i < queries; ++i) 
+        {
+            // Vary the rank a little, without going below 0
+            size_t rank = ranks[q] - std::min<size_t>(ranks[q], i & 7);
+            sink += *values.select(rank);
+        }
+        auto selectNs = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / queries;
+
+        // Baseline: walk the tree in order until the k-th element is reached
+        const int walks = 3;
+        start = high_resolution_clock::now();
+        for (int i = 0; i < walks; ++i) 
+        {
+            size_t index = 0;
+            long found = 0;
+            values.forEach([&](long v) {
+                if (index++ == ranks[q]) found = v;
+            });
+            sink += found;
+        }
+        auto walkNs = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / walks;
+
+        std::cout << names[q] << ": select " << selectNs << " ns, in-order walk "
+                  << walkNs / 1000 << " us (checksum " << sink << ")" << std::endl;
+    }
+}
+
+// Benchmark: insert/erase throughput of the iterative and recursive AVL
+// operations against std::set
+void benchmarkInsertErase(size_t n) 
+{
+    using namespace std::chrono;
+
+    std::vector<int> values(n);
+    std::mt19937 rng(7);
+    for (auto& v : values) 
+    {
+        v = static_cast<int>(rng());
+    }
+
+    auto run = [&](const char* name, auto& set, auto insertFn, auto eraseFn) {
+        auto start = high_resolution_clock::now();
+        for (int v : values) insertFn(set, v);
+        auto mid = high_resolution_clock::now();
+        for (int v : values) eraseFn(set, v);
+        auto stop = high_resolution_clock::now();
+
+        double insertMs = duration_cast<microseconds>(mid - start).count() / 1000.0;
+        double eraseMs = duration_cast<microseconds>(stop - mid).count() / 1000.0;
+        std::cout << name << ": insert " << n / insertMs / 1000 << " M ops/s, erase "
+                  << n / eraseMs / 1000 << " M ops/s" << std::endl;
+    };
+
+    std::cout << "\nInsert/erase benchmark over " << n << " random values" << std::endl;
+    MySet<int> iterative;
+    run("MySet iterative", iterative,
+        [](MySet<int>& s, int v) { s.insert(v); },
+        [](MySet<int>& s, int v) { s.erase(v); });
+    MySet<int> recursive;
+    run("MySet recursive", recursive,
+        [](MySet<int>& s, int v) { s.insertRecursive(v); },
+        [](MySet<int>& s, int v) { s.eraseRecursive(v); });
+    std::set<int> stdSet;
+    run("std::set       ", stdSet,
+        [](std::set<int>& s, int v) { s.insert(v); },
+        [](std::set<int>& s, int v) { s.erase(v); });
+}
+
+// Benchmark: intersection/union at several size ratios, comparing the
+// per-element contains() approach with the merge-based set algebra. Each
+// variant runs twice and the faster run is reported, since the first call
+// after large frees is dominated by the allocator re-faulting pages.
+void benchmarkSetAlgebra(size_t n) 
+{
+    using namespace std::chrono;
+
+    size_t checksum = 0;
+    auto bestMs = [&checksum](auto fn) {
+        double best = 0;
+        for (int run = 0; run < 2; ++run) 
+        {
+            auto start = high_resolution_clock::now();
+            MySet<int> result = fn();
+            double ms = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+            checksum += result.size();
+            if (run == 0 || ms < best) best = ms;
+        }
+        return best;
+    };
+    unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+
+    std::mt19937 rng(11);
+    MySet<int> big;
+    while (big.size() < n) big.insert(static_cast<int>(rng() % (n * 2)));
+
+    std::cout << "\nSet algebra benchmark, |A| = " << n << ", " << threads << " threads (ms)" << std::endl;
+    for (size_t ratio : { 1, 10, 100, 1000 }) 
+    {
+        MySet<int> small;
+        while (small.size() < n / ratio) small.insert(static_cast<int>(rng() % (n * 2)));
+
+        double naiveMs = bestMs([&]() {
+            MySet<int> naive;
+            for (int value : small) 
+            {
+                if (big.contains(value)) naive.insert(value);
+            }
+            return naive;
+        });
+        double interMs = bestMs([&]() { return big.set_intersection(small); });
+        double interParMs = bestMs([&]() { return big.set_intersection(small, threads); });
+        double unionMs = bestMs([&]() { return big.set_union(small); });
+        double unionParMs = bestMs([&]() { return big.set_union(small, threads); });
+
+        std::cout << "1:" << ratio << " intersection: contains loop " << naiveMs << ", merge " << interMs
+                  << ", parallel " << interParMs << " | union: merge " << unionMs
+                  << ", parallel " << unionParMs << std::endl;
+    }
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) 
 {
     MySet<int> mySet;
 
@@ -275,5 +1126,52 @@ int main()
     std::cout << "Set after erasing 40: ";
     mySet.display();
 
+    // Order statistics
+    std::cout << "Size: " << mySet.size() << std::endl;
+    std::cout << "Rank of 30: " << mySet.rank(30) << std::endl;
+    std::cout << "Element at index 2: " << *mySet.select(2) << std::endl;
+    std::cout << "Elements less than 30: " << mySet.count_less(30) << std::endl;
+    std::cout << "Elements in [20, 50]: " << mySet.count_in_range(20, 50) << std::endl;
+
+    // Iterators
+    std::cout << "Iterating from 25: ";
+    for (auto it = mySet.find(25); it != mySet.end(); ++it) 
+    {
+        std::cout << *it << " ";
+    }
+    std::cout << std::endl;
+
+    // Flat (sorted vector) set with the same API
+    MyFlatSet<int> flatSet;
+    int batch[] = { 50, 10, 40, 20, 30 };
+    flatSet.insert_range(batch, batch + 5);
+    flatSet.insert(25);
+    flatSet.erase(40);
+    std::cout << "Flat set: ";
+    flatSet.display();
+    std::cout << "Flat set contains 25? " << (flatSet.contains(25) ? "Yes" : "No") << std::endl;
+
+    // Set algebra
+    MySet<int> other;
+    for (int value : { 5, 25, 30, 60 }) other.insert(value);
+    std::cout << "Union: ";
+    mySet.set_union(other).display();
+    std::cout << "Intersection: ";
+    mySet.set_intersection(other).display();
+    std::cout << "Difference: ";
+    mySet.set_difference(other).display();
+    std::cout << "{25, 30} subset of set? "
+              << (other.set_intersection(mySet).is_subset(mySet) ? "Yes" : "No") << std::endl;
+
+    // Run "./set bench [n]" for the benchmarks (e.g. n = 10000000)
+    if (argc > 1 && std::string(argv[1]) == "bench") 
+    {
+        size_t n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+        benchmarkPercentiles(n);
+        benchmarkInsertErase(n);
+        benchmarkFlatCrossover(std::min<size_t>(n, 1 << 17));
+        benchmarkSetAlgebra(n);
+    }
+
     return 0;
 }
@@ -1,5 +1,383 @@
 #include<iostream>
+#include<atomic>
+#include<vector>
+#include<string>
+#include<random>
+#include<chrono>
+#include<utility>
+#include<cstddef>
+#include<cstdint>
+#include<cstdlib>
+#include<type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#define OPERATIONS_X86 1
+#include<immintrin.h>
+#endif
 using namespace std ;
+
+// Instruction sets the span reductions can use, best last
+enum class SimdLevel { Scalar, SSE, AVX2 };
+
+// Checked once at startup: the kernels below are compiled for SSE4.1 and
+// AVX2 regardless of the build flags and only run where the CPU has them
+inline SimdLevel detectSimd()
+{
+#if defined(OPERATIONS_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE;
+#endif
+    return SimdLevel::Scalar;
+}
+
+inline const char* simdName(SimdLevel level)
+{
+    return level == SimdLevel::AVX2 ? "AVX2" : level == SimdLevel::SSE ? "SSE4.1" : "scalar";
+}
+
+// Element types with vector kernels; everything else stays scalar
+template<class T>
+constexpr bool hasSimdKernels = is_same<T, int>::value || is_same<T, float>::value || is_same<T, double>::value;
+
+// Plain loops: the reference the vector kernels are tested against, and the
+// fallback for other types and CPUs
+template<class T>
+struct ScalarKernels
+{
+    static pair<T, T> minmax(const T* data, size_t n)
+    {
+        T lo = data[0], hi = data[0];
+        for (size_t i = 1; i < n; i++)
+        {
+            lo = (data[i] < lo) ? data[i] : lo ;
+            hi = (data[i] > hi) ? data[i] : hi ;
+        }
+        return { lo, hi };
+    }
+
+    static T max(const T* data, size_t n) { return minmax(data, n).second; }
+    static T min(const T* data, size_t n) { return minmax(data, n).first; }
+
+    static bool equal(const T* a, const T* b, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!(a[i] == b[i])) return false;
+        }
+        return true;
+    }
+
+    // First index holding value at or after start (n if none)
+    static size_t find(const T* data, size_t start, size_t n, T value)
+    {
+        for (size_t i = start; i < n; i++)
+        {
+            if (data[i] == value) return i;
+        }
+        return n;
+    }
+};
+
+#if defined(OPERATIONS_X86) && defined(__GNUC__)
+
+// One set of kernels per instruction set. Each handles whole vectors (two
+// at a time where that hides latency) and leaves the tail to the scalar
+// loop. T is int, float or double; the branches are chosen with if
+// constexpr, so every instantiation only contains its own intrinsics.
+#define OPERATIONS_AVX2 __attribute__((target("avx2")))
+#define OPERATIONS_SSE __attribute__((target("sse4.1")))
+
+template<class T>
+struct Avx2Kernels
+{
+    static constexpr size_t LANES = 32 / sizeof(T);
+
+    OPERATIONS_AVX2 static pair<T, T> minmax(const T* data, size_t n)
+    {
+        if (n < 2 * LANES) return ScalarKernels<T>::minmax(data, n);
+        alignas(32) T lo[LANES], hi[LANES];
+        size_t i = 2 * LANES;
+        if constexpr (is_same<T, float>::value)
+        {
+            __m256 lo0 = _mm256_loadu_ps(data), lo1 = _mm256_loadu_ps(data + LANES);
+            __m256 hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m256 a = _mm256_loadu_ps(data + i), b = _mm256_loadu_ps(data + i + LANES);
+                lo0 = _mm256_min_ps(lo0, a); lo1 = _mm256_min_ps(lo1, b);
+                hi0 = _mm256_max_ps(hi0, a); hi1 = _mm256_max_ps(hi1, b);
+            }
+            _mm256_store_ps(lo, _mm256_min_ps(lo0, lo1));
+            _mm256_store_ps(hi, _mm256_max_ps(hi0, hi1));
+        }
+        else if constexpr (is_same<T, double>::value)
+        {
+            __m256d lo0 = _mm256_loadu_pd(data), lo1 = _mm256_loadu_pd(data + LANES);
+            __m256d hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m256d a = _mm256_loadu_pd(data + i), b = _mm256_loadu_pd(data + i + LANES);
+                lo0 = _mm256_min_pd(lo0, a); lo1 = _mm256_min_pd(lo1, b);
+                hi0 = _mm256_max_pd(hi0, a); hi1 = _mm256_max_pd(hi1, b);
+            }
+            _mm256_store_pd(lo, _mm256_min_pd(lo0, lo1));
+            _mm256_store_pd(hi, _mm256_max_pd(hi0, hi1));
+        }
+        else
+        {
+            const __m256i* p = reinterpret_cast<const __m256i*>(data);
+            __m256i lo0 = _mm256_loadu_si256(p), lo1 = _mm256_loadu_si256(p + 1);
+            __m256i hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + LANES));
+                lo0 = _mm256_min_epi32(lo0, a); lo1 = _mm256_min_epi32(lo1, b);
+                hi0 = _mm256_max_epi32(hi0, a); hi1 = _mm256_max_epi32(hi1, b);
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lo), _mm256_min_epi32(lo0, lo1));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(hi), _mm256_max_epi32(hi0, hi1));
+        }
+        pair<T, T> lanes = ScalarKernels<T>::minmax(lo, LANES);
+        T low = lanes.first, high = ScalarKernels<T>::minmax(hi, LANES).second;
+        for (; i < n; i++)
+        {
+            low = (data[i] < low) ? data[i] : low ;
+            high = (data[i] > high) ? data[i] : high ;
+        }
+        return { low, high };
+    }
+
+    OPERATIONS_AVX2 static T max(const T* data, size_t n)
+    {
+        if (n < 2 * LANES) return ScalarKernels<T>::max(data, n);
+        alignas(32) T hi[LANES];
+        size_t i = 2 * LANES;
+        if constexpr (is_same<T, float>::value)
+        {
+            __m256 hi0 = _mm256_loadu_ps(data), hi1 = _mm256_loadu_ps(data + LANES);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                hi0 = _mm256_max_ps(hi0, _mm256_loadu_ps(data + i));
+                hi1 = _mm256_max_ps(hi1, _mm256_loadu_ps(data + i + LANES));
+            }
+            _mm256_store_ps(hi, _mm256_max_ps(hi0, hi1));
+        }
+        else if constexpr (is_same<T, double>::value)
+        {
+            __m256d hi0 = _mm256_loadu_pd(data), hi1 = _mm256_loadu_pd(data + LANES);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                hi0 = _mm256_max_pd(hi0, _mm256_loadu_pd(data + i));
+                hi1 = _mm256_max_pd(hi1, _mm256_loadu_pd(data + i + LANES));
+            }
+            _mm256_store_pd(hi, _mm256_max_pd(hi0, hi1));
+        }
+        else
+        {
+            const __m256i* p = reinterpret_cast<const __m256i*>(data);
+            __m256i hi0 = _mm256_loadu_si256(p), hi1 = _mm256_loadu_si256(p + 1);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                hi0 = _mm256_max_epi32(hi0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+                hi1 = _mm256_max_epi32(hi1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + LANES)));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(hi), _mm256_max_epi32(hi0, hi1));
+        }
+        T high = ScalarKernels<T>::max(hi, LANES);
+        for (; i < n; i++)
+        {
+            high = (data[i] > high) ? data[i] : high ;
+        }
+        return high;
+    }
+
+    OPERATIONS_AVX2 static T min(const T* data, size_t n)
+    {
+        if (n < 2 * LANES) return ScalarKernels<T>::min(data, n);
+        alignas(32) T lo[LANES];
+        size_t i = 2 * LANES;
+        if constexpr (is_same<T, float>::value)
+        {
+            __m256 lo0 = _mm256_loadu_ps(data), lo1 = _mm256_loadu_ps(data + LANES);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                lo0 = _mm256_min_ps(lo0, _mm256_loadu_ps(data + i));
+                lo1 = _mm256_min_ps(lo1, _mm256_loadu_ps(data + i + LANES));
+            }
+            _mm256_store_ps(lo, _mm256_min_ps(lo0, lo1));
+        }
+        else if constexpr (is_same<T, double>::value)
+        {
+            __m256d lo0 = _mm256_loadu_pd(data), lo1 = _mm256_loadu_pd(data + LANES);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                lo0 = _mm256_min_pd(lo0, _mm256_loadu_pd(data + i));
+                lo1 = _mm256_min_pd(lo1, _mm256_loadu_pd(data + i + LANES));
+            }
+            _mm256_store_pd(lo, _mm256_min_pd(lo0, lo1));
+        }
+        else
+        {
+            const __m256i* p = reinterpret_cast<const __m256i*>(data);
+            __m256i lo0 = _mm256_loadu_si256(p), lo1 = _mm256_loadu_si256(p + 1);
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                lo0 = _mm256_min_epi32(lo0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+                lo1 = _mm256_min_epi32(lo1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + LANES)));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lo), _mm256_min_epi32(lo0, lo1));
+        }
+        T low = ScalarKernels<T>::min(lo, LANES);
+        for (; i < n; i++)
+        {
+            low = (data[i] < low) ? data[i] : low ;
+        }
+        return low;
+    }
+
+    // Bitmask of the lanes where a and b (or data and value) are equal
+    OPERATIONS_AVX2 static int equalMask(const T* a, const T* b)
+    {
+        if constexpr (is_same<T, float>::value)
+            return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b), _CMP_EQ_OQ));
+        else if constexpr (is_same<T, double>::value)
+            return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(a), _mm256_loadu_pd(b), _CMP_EQ_OQ));
+        else
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)))));
+    }
+
+    OPERATIONS_AVX2 static bool equal(const T* a, const T* b, size_t n)
+    {
+        const int all = (1 << LANES) - 1;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            if (equalMask(a + i, b + i) != all) return false;
+        }
+        return ScalarKernels<T>::equal(a + i, b + i, n - i);
+    }
+
+    OPERATIONS_AVX2 static size_t find(const T* data, size_t start, size_t n, T value)
+    {
+        alignas(32) T needle[LANES];
+        for (size_t lane = 0; lane < LANES; lane++) needle[lane] = value;
+        size_t i = start;
+        for (; i + LANES <= n; i += LANES)
+        {
+            int mask = equalMask(data + i, needle);
+            if (mask) return i + __builtin_ctz(mask);
+        }
+        return ScalarKernels<T>::find(data, i, n, value);
+    }
+};
+
+template<class T>
+struct SseKernels
+{
+    static constexpr size_t LANES = 16 / sizeof(T);
+
+    OPERATIONS_SSE static pair<T, T> minmax(const T* data, size_t n)
+    {
+        if (n < 2 * LANES) return ScalarKernels<T>::minmax(data, n);
+        alignas(16) T lo[LANES], hi[LANES];
+        size_t i = 2 * LANES;
+        if constexpr (is_same<T, float>::value)
+        {
+            __m128 lo0 = _mm_loadu_ps(data), lo1 = _mm_loadu_ps(data + LANES);
+            __m128 hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m128 a = _mm_loadu_ps(data + i), b = _mm_loadu_ps(data + i + LANES);
+                lo0 = _mm_min_ps(lo0, a); lo1 = _mm_min_ps(lo1, b);
+                hi0 = _mm_max_ps(hi0, a); hi1 = _mm_max_ps(hi1, b);
+            }
+            _mm_store_ps(lo, _mm_min_ps(lo0, lo1));
+            _mm_store_ps(hi, _mm_max_ps(hi0, hi1));
+        }
+        else if constexpr (is_same<T, double>::value)
+        {
+            __m128d lo0 = _mm_loadu_pd(data), lo1 = _mm_loadu_pd(data + LANES);
+            __m128d hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m128d a = _mm_loadu_pd(data + i), b = _mm_loadu_pd(data + i + LANES);
+                lo0 = _mm_min_pd(lo0, a); lo1 = _mm_min_pd(lo1, b);
+                hi0 = _mm_max_pd(hi0, a); hi1 = _mm_max_pd(hi1, b);
+            }
+            _mm_store_pd(lo, _mm_min_pd(lo0, lo1));
+            _mm_store_pd(hi, _mm_max_pd(hi0, hi1));
+        }
+        else
+        {
+            const __m128i* p = reinterpret_cast<const __m128i*>(data);
+            __m128i lo0 = _mm_loadu_si128(p), lo1 = _mm_loadu_si128(p + 1);
+            __m128i hi0 = lo0, hi1 = lo1;
+            for (; i + 2 * LANES <= n; i += 2 * LANES)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + LANES));
+                lo0 = _mm_min_epi32(lo0, a); lo1 = _mm_min_epi32(lo1, b);
+                hi0 = _mm_max_epi32(hi0, a); hi1 = _mm_max_epi32(hi1, b);
+            }
+            _mm_store_si128(reinterpret_cast<__m128i*>(lo), _mm_min_epi32(lo0, lo1));
+            _mm_store_si128(reinterpret_cast<__m128i*>(hi), _mm_max_epi32(hi0, hi1));
+        }
+        T low = ScalarKernels<T>::min(lo, LANES), high = ScalarKernels<T>::max(hi, LANES);
+        for (; i < n; i++)
+        {
+            low = (data[i] < low) ? data[i] : low ;
+            high = (data[i] > high) ? data[i] : high ;
+        }
+        return { low, high };
+    }
+
+    // min and max alone are the minmax loop with one half unused; the
+    // compiler drops that half after inlining
+    OPERATIONS_SSE static T max(const T* data, size_t n) { return minmax(data, n).second; }
+    OPERATIONS_SSE static T min(const T* data, size_t n) { return minmax(data, n).first; }
+
+    OPERATIONS_SSE static int equalMask(const T* a, const T* b)
+    {
+        if constexpr (is_same<T, float>::value)
+            return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+        else if constexpr (is_same<T, double>::value)
+            return _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+        else
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)))));
+    }
+
+    OPERATIONS_SSE static bool equal(const T* a, const T* b, size_t n)
+    {
+        const int all = (1 << LANES) - 1;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            if (equalMask(a + i, b + i) != all) return false;
+        }
+        return ScalarKernels<T>::equal(a + i, b + i, n - i);
+    }
+
+    OPERATIONS_SSE static size_t find(const T* data, size_t start, size_t n, T value)
+    {
+        alignas(16) T needle[LANES];
+        for (size_t lane = 0; lane < LANES; lane++) needle[lane] = value;
+        size_t i = start;
+        for (; i + LANES <= n; i += LANES)
+        {
+            int mask = equalMask(data + i, needle);
+            if (mask) return i + __builtin_ctz(mask);
+        }
+        return ScalarKernels<T>::find(data, i, n, value);
+    }
+};
+
+#endif
+
 template<class T>
 
 class Operations
@@ -7,30 +385,215 @@ class Operations
     private:
         T num1 ;
         T num2 ;
+
+        // Instruction set used by the span functions (detected once); atomic
+        // so span calls on other threads may run while it is changed
+        static atomic<SimdLevel>& level()
+        {
+            static atomic<SimdLevel> current(detectSimd());
+            return current;
+        }
+
+        // Run the kernel of the active instruction set: Kernels<T>::op(args)
+#if defined(OPERATIONS_X86) && defined(__GNUC__)
+#define OPERATIONS_DISPATCH(op, ...)                                                  \
+        if constexpr (hasSimdKernels<T>)                                              \
+        {                                                                             \
+            SimdLevel active = level().load(memory_order_relaxed);                    \
+            if (active == SimdLevel::AVX2) return Avx2Kernels<T>::op(__VA_ARGS__);    \
+            if (active == SimdLevel::SSE) return SseKernels<T>::op(__VA_ARGS__);      \
+        }                                                                             \
+        return ScalarKernels<T>::op(__VA_ARGS__)
+#else
+#define OPERATIONS_DISPATCH(op, ...) return ScalarKernels<T>::op(__VA_ARGS__)
+#endif
+
     public:
+        static_assert(is_arithmetic<T>::value, "Operations<T> needs an arithmetic T");
+
         Operations(T temp1 , T temp2) : num1(temp1) , num2(temp2){}
         T max1()
         {
-            cout<<"Max = ";
             return (num1>num2)?num1:num2 ;
         }
         T min1()
         {
-            cout<<"Min = ";
             return (num1<num2)?num1:num2 ;
         }
         bool IsEqual()
         {
-            cout<<"Equality check.. ";
             return(num1 == num2) ;
         }
+
+        // Reductions over data[0..n). int, float and double use SSE4.1 or
+        // AVX2 kernels when the CPU has them, other types a plain loop.
+        // max/min/minmax/argmax need n > 0; NaNs give an unspecified result.
+        static T max(const T* data, size_t n)
+        {
+            OPERATIONS_DISPATCH(max, data, n);
+        }
+
+        static T min(const T* data, size_t n)
+        {
+            OPERATIONS_DISPATCH(min, data, n);
+        }
+
+        static pair<T, T> minmax(const T* data, size_t n)
+        {
+            OPERATIONS_DISPATCH(minmax, data, n);
+        }
+
+        static bool equal(const T* a, const T* b, size_t n)
+        {
+            OPERATIONS_DISPATCH(equal, a, b, n);
+        }
+
+        // Index of the first maximum: one pass for the maximum, one to find it
+        static size_t argmax(const T* data, size_t n)
+        {
+            T high = max(data, n);
+            OPERATIONS_DISPATCH(find, data, 0, n, high);
+        }
+
+#undef OPERATIONS_DISPATCH
+
+        static T max(const vector<T>& data) { return max(data.data(), data.size()); }
+        static T min(const vector<T>& data) { return min(data.data(), data.size()); }
+        static pair<T, T> minmax(const vector<T>& data) { return minmax(data.data(), data.size()); }
+        static size_t argmax(const vector<T>& data) { return argmax(data.data(), data.size()); }
+        static bool equal(const vector<T>& a, const vector<T>& b)
+        {
+            return a.size() == b.size() && equal(a.data(), b.data(), a.size());
+        }
+
+        // Instruction set in use; can be lowered (e.g. to compare kernels)
+        // but not raised above what the CPU supports
+        static SimdLevel simdLevel() { return level().load(memory_order_relaxed); }
+        static void setSimdLevel(SimdLevel wanted)
+        {
+            level().store(std::min(wanted, detectSimd()), memory_order_relaxed);
+        }
 };
 
-int main()
+// Random values of T, with a few exact duplicates of the extremes
+template<class T>
+vector<T> randomValues(size_t n, mt19937& rng)
+{
+    vector<T> values(n);
+    for (auto& value : values)
+    {
+        if constexpr (is_floating_point<T>::value)
+            value = static_cast<T>(uniform_real_distribution<double>(-1e6, 1e6)(rng));
+        else
+            value = static_cast<T>(rng());
+    }
+    if (n > 2)
+    {
+        values[rng() % n] = values[rng() % n];
+    }
+    return values;
+}
+
+// Every instruction set against the scalar reference, for all lengths up
+// to 200 and unaligned starts. Returns the number of mismatches.
+template<class T>
+int checkOperations(const char* name)
+{
+    mt19937 rng(42);
+    int failures = 0;
+    for (size_t n = 1; n <= 200; n++)
+    {
+        for (size_t offset = 0; offset < 3; offset++)
+        {
+            vector<T> a = randomValues<T>(n + offset, rng);
+            vector<T> b = a;
+            if (rng() % 2) b[offset + rng() % n] += 1;
+            const T* x = a.data() + offset;
+            const T* y = b.data() + offset;
+
+            pair<T, T> expected = ScalarKernels<T>::minmax(x, n);
+            size_t expectedArg = ScalarKernels<T>::find(x, 0, n, expected.second);
+            bool expectedEqual = ScalarKernels<T>::equal(x, y, n);
+
+            for (SimdLevel wanted : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 })
+            {
+                Operations<T>::setSimdLevel(wanted);
+                failures += Operations<T>::max(x, n) != expected.second;
+                failures += Operations<T>::min(x, n) != expected.first;
+                failures += Operations<T>::minmax(x, n) != expected;
+                failures += Operations<T>::argmax(x, n) != expectedArg;
+                failures += Operations<T>::equal(x, y, n) != expectedEqual;
+            }
+        }
+    }
+    Operations<T>::setSimdLevel(SimdLevel::AVX2);
+    cout << "  " << name << ": " << (failures ? "FAILED" : "ok") << "\n";
+    return failures;
+}
+
+// Throughput of each reduction per instruction set, in GB/s of input read
+template<class T>
+void benchmarkOperations(const char* name, size_t n)
+{
+    mt19937 rng(7);
+    vector<T> a = randomValues<T>(n, rng);
+    vector<T> b = a;
+    int rounds = static_cast<int>(max<size_t>(1, (size_t(1) << 28) / (n * sizeof(T))));
+
+    cout << name << " (" << n << " elements)\n";
+    for (SimdLevel wanted : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 })
+    {
+        Operations<T>::setSimdLevel(wanted);
+        if (Operations<T>::simdLevel() != wanted || (!hasSimdKernels<T> && wanted != SimdLevel::Scalar)) continue;
+
+        auto rate = [&](auto op, size_t bytesPerElement) {
+            double sink = 0;
+            auto start = chrono::steady_clock::now();
+            for (int r = 0; r < rounds; r++) sink += static_cast<double>(op());
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            return sink == 0.5 ? 0.0 : rounds * double(n) * bytesPerElement / seconds / 1e9;
+        };
+        cout << "  " << simdName(wanted)
+             << ": max " << rate([&]() { return Operations<T>::max(a); }, sizeof(T))
+             << ", min " << rate([&]() { return Operations<T>::min(a); }, sizeof(T))
+             << ", minmax " << rate([&]() { return Operations<T>::minmax(a).second; }, sizeof(T))
+             << ", argmax " << rate([&]() { return Operations<T>::argmax(a); }, sizeof(T))
+             << ", equal " << rate([&]() { return Operations<T>::equal(a, b); }, 2 * sizeof(T))
+             << " GB/s\n";
+    }
+    Operations<T>::setSimdLevel(SimdLevel::AVX2);
+}
+
+int main(int argc, char* argv[])
 {
     Operations<int> oper(12,14) ;
-    cout<<oper.max1()<<"\n"<<oper.min1()<<"\n"<<oper.IsEqual()<<"\n";
+    cout<<"Max = "<<oper.max1()<<"\n"<<"Min = "<<oper.min1()<<"\n"<<"Equality check.. "<<oper.IsEqual()<<"\n";
     Operations<float> oper1(1.52,1.52) ;
-    cout<<oper1.max1()<<"\n"<<oper1.min1()<<"\n"<<oper1.IsEqual()<<"\n";
+    cout<<"Max = "<<oper1.max1()<<"\n"<<"Min = "<<oper1.min1()<<"\n"<<"Equality check.. "<<oper1.IsEqual()<<"\n";
+
+    vector<int> values = { 4, -2, 19, 7, 19, 0, -8, 3, 11, 5 };
+    pair<int, int> range = Operations<int>::minmax(values);
+    cout<<"Span ("<<simdName(Operations<int>::simdLevel())<<"): max = "<<Operations<int>::max(values)
+        <<", min = "<<range.first<<", argmax = "<<Operations<int>::argmax(values)<<"\n";
+
+    // "./simple_template test" checks every kernel against the scalar
+    // loops, "./simple_template bench [n]" measures them
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "test")
+    {
+        cout<<"Kernels vs scalar (CPU supports "<<simdName(detectSimd())<<")\n";
+        int failures = checkOperations<int>("int") + checkOperations<float>("float") +
+                       checkOperations<double>("double") + checkOperations<short>("short") +
+                       checkOperations<long long>("long long");
+        return failures ? 1 : 0;
+    }
+    if (mode == "bench")
+    {
+        size_t n = argc > 2 ? strtoul(argv[2], nullptr, 10) : (1 << 16);
+        benchmarkOperations<int>("int", n);
+        benchmarkOperations<float>("float", n);
+        benchmarkOperations<double>("double", n);
+        benchmarkOperations<short>("short (scalar only)", n);
+    }
     return 0 ;
 }
@@ -3,148 +3,2880 @@
 #include <list>
 #include <utility>
 #include <functional>
+#include <memory>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <string_view>
+#include <new>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <optional>
+#include <atomic>
+#include <cmath>
+#include <array>
+#include <stdexcept>
+#include <cstdio>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
+// Hint the CPU to start loading address into cache (a no-op where the
+// compiler has no prefetch builtin)
+inline void prefetch(const void* address) 
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Spread the bits of a std::hash result. std::hash<int> is the identity on
+// common standard libraries, which leaves the low and high bits that the
+// tables below rely on badly distributed.
+inline size_t mixHash(size_t h) 
+{
+    uint64_t x = static_cast<uint64_t>(h);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+// Default hasher of UnorderedMap. For std::string keys it is transparent:
+// std::string_view and const char* hash exactly like the equal std::string,
+// so looking them up needs no temporary string.
+template <typename Key>
+struct MapHash : std::hash<Key> {};
+
+template <>
+struct MapHash<std::string> 
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const 
+    {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+// Snapshot of a hash table's health, from stats() of an instrumented table.
+// A bad hash shows up as long chains at a low load factor; a bad load as
+// a high elements/buckets ratio with chains that are long everywhere.
+struct HashTableStats 
+{
+    size_t elements = 0;
+    size_t buckets = 0;
+    std::vector<size_t> occupancy;  // occupancy[k]: buckets holding k entries (the last counts k or more)
+    size_t maxChain = 0;
+    double meanChain = 0;           // Entries per non-empty bucket
+    size_t rehashes = 0;
+    double rehashSeconds = 0;
+    size_t lookups = 0;             // Including the ones inserts do
+    double collisionsPerLookup = 0; // Other keys examined per lookup
+    size_t memoryBytes = 0;         // Table and nodes, not memory owned by keys/values
+};
+
+// Write stats as "prefix_metric value" lines (Prometheus text format)
+inline void dumpStats(std::ostream& out, const std::string& prefix, const HashTableStats& stats) 
+{
+    out << prefix << "_elements " << stats.elements << "\n"
+        << prefix << "_buckets " << stats.buckets << "\n";
+    for (size_t k = 0; k < stats.occupancy.size(); k++) 
+    {
+        out << prefix << "_bucket_occupancy{entries=\"" << k
+            << (k + 1 == stats.occupancy.size() ? "+" : "") << "\"} " << stats.occupancy[k] << "\n";
+    }
+    out << prefix << "_max_chain " << stats.maxChain << "\n"
+        << prefix << "_mean_chain " << stats.meanChain << "\n"
+        << prefix << "_rehashes " << stats.rehashes << "\n"
+        << prefix << "_rehash_seconds " << stats.rehashSeconds << "\n"
+        << prefix << "_lookups " << stats.lookups << "\n"
+        << prefix << "_collisions_per_lookup " << stats.collisionsPerLookup << "\n"
+        << prefix << "_memory_bytes " << stats.memoryBytes << std::endl;
+}
+
+// Event counters of an instrumented table. The disabled version is an empty
+// base class whose hooks do nothing, so it costs neither space nor time.
+template <bool Enabled>
+struct HashTableCounters 
+{
+    struct Timer {};
+    void recordLookup(size_t) const {}
+    Timer rehashStarted() const { return {}; }
+    void rehashFinished(Timer) {}
+    void fillCounters(HashTableStats&) const {}
+};
+
+// Lookups are counted from const find(), which several threads may call at
+// once, so those counters are relaxed atomics. Rehashes only happen in
+// writers, which run alone.
+template <>
+struct HashTableCounters<true> 
+{
+    using Timer = std::chrono::steady_clock::time_point;
+    mutable std::atomic<size_t> lookups{0};
+    mutable std::atomic<size_t> collisions{0};
+    size_t rehashes = 0;
+    double rehashSeconds = 0;
+
+    HashTableCounters() = default;
+
+    HashTableCounters(const HashTableCounters& other)
+        : lookups(other.lookups.load(std::memory_order_relaxed)),
+          collisions(other.collisions.load(std::memory_order_relaxed)),
+          rehashes(other.rehashes), rehashSeconds(other.rehashSeconds) {}
+
+    HashTableCounters& operator=(const HashTableCounters& other) 
+    {
+        lookups.store(other.lookups.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        collisions.store(other.collisions.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        rehashes = other.rehashes;
+        rehashSeconds = other.rehashSeconds;
+        return *this;
+    }
+
+    void recordLookup(size_t otherKeysSeen) const 
+    {
+        lookups.fetch_add(1, std::memory_order_relaxed);
+        collisions.fetch_add(otherKeysSeen, std::memory_order_relaxed);
+    }
+
+    Timer rehashStarted() const 
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    void rehashFinished(Timer start) 
+    {
+        rehashes++;
+        rehashSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void fillCounters(HashTableStats& stats) const 
+    {
+        stats.rehashes = rehashes;
+        stats.rehashSeconds = rehashSeconds;
+        stats.lookups = lookups.load(std::memory_order_relaxed);
+        size_t collided = collisions.load(std::memory_order_relaxed);
+        stats.collisionsPerLookup = stats.lookups ? static_cast<double>(collided) / stats.lookups : 0.0;
+    }
+};
+
+// With Instrumented = true the table counts lookups, collisions and rehashes
+// and stats() reports them together with its bucket occupancy
+template <typename Key, typename Value, typename Hash = MapHash<Key>, bool Instrumented = false>
+class UnorderedMap : private HashTableCounters<Instrumented> 
+{
+private:
+    // Node for the hashmap's buckets
+    struct Node 
+    {
+        size_t hash;     // Cached full (mixed) hash of key
+        Key key;
+        Value value;
+
+        // Construct key and value in place from forwarded arguments
+        template <typename K, typename... Args>
+        Node(size_t h, K&& k, Args&&... args)
+            : hash(h), key(std::forward<K>(k)), value(std::forward<Args>(args)...) {}
+    };
+
+    // Vector of buckets (each bucket is a list of nodes)
+    std::vector<std::list<Node>> buckets;
+    size_t bucketCount;  // Number of buckets (always a power of two)
+    size_t size;         // Total number of elements
+    float loadFactor;    // Maximum load factor
+
+    // Incremental rehashing: while oldBuckets is not empty it holds the old
+    // buckets whose entries have not been moved into buckets yet (migration
+    // pops them from the back), so lookups have to check both tables.
+    // nextBuckets is the following, twice as big, table; it is reserved up
+    // front and its empty lists are constructed a few per operation, so
+    // neither building nor freeing a bucket array happens in one go.
+    std::vector<std::list<Node>> oldBuckets;
+    std::vector<std::list<Node>> nextBuckets;
+    size_t oldBucketCount; // Bucket count the old table was hashed with
+    size_t rehashStep;     // Old buckets migrated per operation (0 = rehash all at once)
+
+    // Hash function (K is Key or, with a transparent Hash, anything comparable
+    // to it). The result is mixed so that masking off the low bits is enough
+    // to pick a bucket, and it is computed once per operation.
+    template <typename K>
+    static size_t hashOf(const K& key) 
+    {
+        return mixHash(Hash{}(key));
+    }
+
+    // Bucket index of a hash in the current table
+    size_t bucketIndex(size_t hash) const 
+    {
+        return hash & (bucketCount - 1);
+    }
+
+    // How many keys ahead the batch operations prefetch: a key's bucket is
+    // prefetched 2 * PREFETCH_DISTANCE keys before it is probed and the
+    // bucket's first node PREFETCH_DISTANCE keys before, so both loads have
+    // arrived by then and several cache misses are always in flight
+    static constexpr size_t PREFETCH_DISTANCE = 8;
+
+    void prefetchFirstNode(size_t hash) const 
+    {
+        const auto& bucket = buckets[bucketIndex(hash)];
+        if (!bucket.empty()) 
+        {
+            prefetch(&bucket.front());
+        }
+    }
+
+    // Call probe(i, hash of key i) for i = 0 .. count-1, hashing each key
+    // and prefetching its bucket and first node in the pipeline above
+    template <typename KeyAt, typename Probe>
+    void pipelined(size_t count, KeyAt keyAt, Probe probe) 
+    {
+        const size_t ahead = 2 * PREFETCH_DISTANCE;
+        size_t hashes[2 * ahead]; // Ring buffer of the hashes in flight
+
+        for (size_t j = 0; j < std::min(ahead, count); j++) 
+        {
+            hashes[j] = hashOf(keyAt(j));
+            prefetch(&buckets[bucketIndex(hashes[j])]);
+        }
+        for (size_t j = 0; j < std::min(PREFETCH_DISTANCE, count); j++) 
+        {
+            prefetchFirstNode(hashes[j]);
+        }
+
+        for (size_t i = 0; i < count; i++) 
+        {
+            if (i + ahead < count) 
+            {
+                size_t& hash = hashes[(i + ahead) % (2 * ahead)];
+                hash = hashOf(keyAt(i + ahead));
+                prefetch(&buckets[bucketIndex(hash)]);
+            }
+            if (i + PREFETCH_DISTANCE < count) 
+            {
+                prefetchFirstNode(hashes[(i + PREFETCH_DISTANCE) % (2 * ahead)]);
+            }
+            probe(i, hashes[i % (2 * ahead)]);
+        }
+    }
+
+    // insert_or_assign with the hash already computed
+    template <typename K, typename M>
+    std::pair<Value*, bool> assignHashed(K&& key, size_t hash, M&& value) 
+    {
+        if (Node* node = findNode(key, hash)) 
+        {
+            node->value = std::forward<M>(value);
+            return { &node->value, false };
+        }
+
+        std::list<Node> staging;
+        staging.emplace_back(hash, std::forward<K>(key), std::forward<M>(value));
+        return { &link(staging).value, true };
+    }
+
+    // Index of a hash in the old table; >= oldBuckets.size() if that bucket was already migrated
+    size_t oldIndex(size_t hash) const 
+    {
+        return oldBuckets.empty() ? 0 : hash & (oldBucketCount - 1);
+    }
+
+    // Splice every node of bucket into the current table, so nothing is
+    // copied or reallocated and references to values stay valid. Keys are
+    // not rehashed: every node carries its hash.
+    void moveNodes(std::list<Node>& bucket) 
+    {
+        while (!bucket.empty()) 
+        {
+            size_t newIndex = bucketIndex(bucket.front().hash);
+            buckets[newIndex].splice(buckets[newIndex].end(), bucket, bucket.begin());
+        }
+    }
+
+    // Move up to count old buckets into the new table
+    void migrateStep(size_t count) 
+    {
+        while (count-- > 0 && !oldBuckets.empty()) 
+        {
+            moveNodes(oldBuckets.back());
+            oldBuckets.pop_back();
+        }
+
+        if (oldBuckets.empty() && oldBuckets.capacity() > 0) 
+        {
+            std::vector<std::list<Node>>().swap(oldBuckets);
+        }
+    }
+
+    // Construct up to count empty buckets of the next table
+    void prebuildStep(size_t count) 
+    {
+        if (nextBuckets.capacity() < bucketCount * 2) 
+        {
+            nextBuckets.reserve(bucketCount * 2);
+        }
+        while (count-- > 0 && nextBuckets.size() < bucketCount * 2) 
+        {
+            nextBuckets.emplace_back();
+        }
+    }
+
+    // Smallest usable incremental step. After growing to B buckets, B/2 old
+    // buckets must be migrated (step per operation) and the 2B buckets of the
+    // next table built (4 * step per operation): B / step operations in all.
+    // Only lf * B / 2 inserts fit before the table grows again, so the step
+    // must be at least 2 / lf; one more absorbs rounding. With a smaller
+    // step rehash() would have to finish the leftover work in one go.
+    static size_t minimumRehashStep(float maxLoadFactor) 
+    {
+        return static_cast<size_t>(std::ceil(2.0f / std::max(maxLoadFactor, 0.01f))) + 1;
+    }
+
+    // Bounded rehash work done at the start of every operation
+    void incrementalStep() 
+    {
+        if (rehashStep == 0) 
+        {
+            return;
+        }
+        if (!oldBuckets.empty()) 
+        {
+            migrateStep(rehashStep);
+        }
+        else 
+        {
+            prebuildStep(rehashStep * 4);
+        }
+    }
+
+    // Find the node holding key in either table. Keys are only compared
+    // when the cached hashes match.
+    template <typename K>
+    Node* findNode(const K& key, size_t hash) 
+    {
+        return const_cast<Node*>(static_cast<const UnorderedMap*>(this)->findNode(key, hash));
+    }
+
+    template <typename K>
+    const Node* findNode(const K& key, size_t hash) const 
+    {
+        size_t seen = 0; // Other keys looked at (only used when instrumented)
+        for (auto& node : buckets[bucketIndex(hash)]) 
+        {
+            if (node.hash == hash && node.key == key) 
+            {
+                this->recordLookup(seen);
+                return &node;
+            }
+            seen++;
+        }
+
+        size_t index = oldIndex(hash);
+        if (index < oldBuckets.size()) 
+        {
+            for (auto& node : oldBuckets[index]) 
+            {
+                if (node.hash == hash && node.key == key) 
+                {
+                    this->recordLookup(seen);
+                    return &node;
+                }
+                seen++;
+            }
+        }
+        this->recordLookup(seen);
+        return nullptr;
+    }
+
+    // Unlink the node holding key from whichever table has it
+    template <typename K>
+    bool eraseNode(const K& key) 
+    {
+        size_t hash = hashOf(key);
+        size_t index = bucketIndex(hash);
+        for (auto it = buckets[index].begin(); it != buckets[index].end(); ++it) 
+        {
+            if (it->hash == hash && it->key == key) 
+            {
+                buckets[index].erase(it);
+                size--;
+                return true;
+            }
+        }
+
+        index = oldIndex(hash);
+        if (index < oldBuckets.size()) 
+        {
+            for (auto it = oldBuckets[index].begin(); it != oldBuckets[index].end(); ++it) 
+            {
+                if (it->hash == hash && it->key == key) 
+                {
+                    oldBuckets[index].erase(it);
+                    size--;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Rehash to increase the bucket count and redistribute elements
+    void rehash() 
+    {
+        auto timer = this->rehashStarted();
+        size_t newBucketCount = bucketCount * 2;
+
+        if (rehashStep > 0) 
+        {
+            // Only swap in the bigger table here; the entries follow a few
+            // buckets at a time from subsequent operations. Both loops below
+            // are no-ops unless the operations could not keep up.
+            migrateStep(oldBuckets.size());
+            prebuildStep(newBucketCount);
+            oldBuckets = std::move(buckets);
+            oldBucketCount = bucketCount;
+            buckets = std::move(nextBuckets);
+            nextBuckets = std::vector<std::list<Node>>();
+            bucketCount = newBucketCount;
+            this->rehashFinished(timer);
+            return;
+        }
+
+        std::vector<std::list<Node>> oldTable(newBucketCount);
+        oldTable.swap(buckets);
+        bucketCount = newBucketCount;
+
+        for (auto& bucket : oldTable) 
+        {
+            moveNodes(bucket);
+        }
+        this->rehashFinished(timer);
+    }
+
+    // Link a freshly built node into the table (the key must be absent)
+    Node& link(std::list<Node>& staging) 
+    {
+        auto& bucket = buckets[bucketIndex(staging.front().hash)];
+        bucket.splice(bucket.end(), staging);
+        size++;
+        Node& node = bucket.back();
+
+        // Check load factor and rehash if necessary (nodes never move in memory)
+        if (static_cast<float>(size) / bucketCount > loadFactor) 
+        {
+            rehash();
+        }
+        return node;
+    }
+
+public:
+    // Constructor. With incrementalRehashStep > 0 growing the table never
+    // moves all entries at once: each later operation migrates that many
+    // old buckets instead. The step is raised to minimumRehashStep (4 at
+    // the default load factor of 0.75), so every operation does a bounded
+    // amount of work.
+    // The bucket count is rounded up to a power of two.
+    UnorderedMap(size_t initialBucketCount = 8, float maxLoadFactor = 0.75, size_t incrementalRehashStep = 0)
+        : bucketCount(1), size(0), loadFactor(maxLoadFactor), oldBucketCount(0),
+          rehashStep(incrementalRehashStep ? std::max(incrementalRehashStep, minimumRehashStep(maxLoadFactor)) : 0) {
+        while (bucketCount < initialBucketCount) bucketCount *= 2;
+        buckets.resize(bucketCount);
+    }
+
+    // Insert the value built from args under key unless key is already
+    // present. Neither key nor args are touched in that case. Returns the
+    // value and whether it was inserted.
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> try_emplace(K&& key, Args&&... args) 
+    {
+        size_t hash = hashOf(key);
+        return try_emplace_hashed(std::forward<K>(key), hash, std::forward<Args>(args)...);
+    }
+
+    // The hash the table uses for key. Callers that need the hash anyway,
+    // or touch the same key twice, pass it to the *_hashed variants below
+    // so the key is hashed only once.
+    template <typename K>
+    static size_t hash_of(const K& key) 
+    {
+        return hashOf(key);
+    }
+
+    // try_emplace with hash == hash_of(key) already computed
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> try_emplace_hashed(K&& key, size_t hash, Args&&... args) 
+    {
+        incrementalStep();
+
+        if (Node* node = findNode(key, hash)) 
+        {
+            return { &node->value, false };
+        }
+
+        std::list<Node> staging;
+        staging.emplace_back(hash, std::forward<K>(key), std::forward<Args>(args)...);
+        return { &link(staging).value, true };
+    }
+
+    // find with hash == hash_of(key) already computed
+    template <typename K>
+    Value* find_hashed(const K& key, size_t hash) 
+    {
+        incrementalStep();
+
+        Node* node = findNode(key, hash);
+        return node ? &node->value : nullptr;
+    }
+
+    // Insert, or assign to the existing value, perfectly forwarding both
+    template <typename K, typename M>
+    std::pair<Value*, bool> insert_or_assign(K&& key, M&& value) 
+    {
+        incrementalStep();
+
+        size_t hash = hashOf(key);
+        return assignHashed(std::forward<K>(key), hash, std::forward<M>(value));
+    }
+
+    // Build a node from args (key first, then the value's constructor
+    // arguments) and insert it unless its key is already present
+    template <typename... Args>
+    std::pair<Value*, bool> emplace(Args&&... args) 
+    {
+        incrementalStep();
+
+        std::list<Node> staging;
+        staging.emplace_back(0, std::forward<Args>(args)...);
+        Node& fresh = staging.front();
+        fresh.hash = hashOf(fresh.key);
+        if (Node* node = findNode(fresh.key, fresh.hash)) 
+        {
+            return { &node->value, false };
+        }
+        return { &link(staging).value, true };
+    }
+
+    // Insert or update a key-value pair
+    void insert(const Key& key, const Value& value)
+    {
+        insert_or_assign(key, value);
+    }
+
+    // Find a value by key
+    Value* find(const Key& key) 
+    {
+        incrementalStep();
+
+        Node* node = findNode(key, hashOf(key));
+        return node ? &node->value : nullptr; // nullptr if key not found
+    }
+
+    // Find by anything the transparent hasher accepts (e.g. "Bob" or a
+    // std::string_view for std::string keys) without building a Key
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    Value* find(const K& key) 
+    {
+        incrementalStep();
+
+        Node* node = findNode(key, hashOf(key));
+        return node ? &node->value : nullptr;
+    }
+
+    // Look up count keys at once: out[i] is the value of keys[i] or nullptr.
+    // Keys are hashed and their buckets prefetched well before they are
+    // probed, so the cache misses of many keys overlap instead of each
+    // lookup waiting for its own in turn. Each key does the incremental
+    // rehash work of one find.
+    void find_batch(const Key* keys, size_t count, Value** out) 
+    {
+        pipelined(count,
+                  [keys](size_t i) -> const Key& { return keys[i]; },
+                  [this, keys, out](size_t i, size_t hash) {
+                      incrementalStep();
+                      Node* node = findNode(keys[i], hash);
+                      out[i] = node ? &node->value : nullptr;
+                  });
+    }
+
+    void find_batch(const std::vector<Key>& keys, std::vector<Value*>& out) 
+    {
+        out.resize(keys.size());
+        find_batch(keys.data(), keys.size(), out.data());
+    }
+
+    // Insert or update count key-value pairs, prefetching like find_batch
+    // (a rehash in the middle only makes some prefetches useless). Each
+    // item does the incremental rehash work of one insert, so a big batch
+    // never outruns the migration.
+    void insert_batch(const std::pair<Key, Value>* items, size_t count) 
+    {
+        pipelined(count,
+                  [items](size_t i) -> const Key& { return items[i].first; },
+                  [this, items](size_t i, size_t hash) {
+                      incrementalStep();
+                      assignHashed(items[i].first, hash, items[i].second);
+                  });
+    }
+
+    void insert_batch(const std::vector<std::pair<Key, Value>>& items) 
+    {
+        insert_batch(items.data(), items.size());
+    }
+
+    // Read-only lookups: they skip the incremental rehash work, so several
+    // threads may call them at once while nobody modifies the map
+    const Value* find(const Key& key) const 
+    {
+        const Node* node = findNode(key, hashOf(key));
+        return node ? &node->value : nullptr;
+    }
+
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    const Value* find(const K& key) const 
+    {
+        const Node* node = findNode(key, hashOf(key));
+        return node ? &node->value : nullptr;
+    }
+
+    // Erase a key-value pair by key; returns whether it was present
+    bool erase(const Key& key) 
+    {
+        incrementalStep();
+        return eraseNode(key);
+    }
+
+    // Erase by anything the transparent hasher accepts
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    bool erase(const K& key) 
+    {
+        incrementalStep();
+        return eraseNode(key);
+    }
+
+    // Access or insert a key-value pair using []
+    Value& operator[](const Key& key) 
+    {
+        return *try_emplace(key).first;
+    }
+
+    Value& operator[](Key&& key) 
+    {
+        return *try_emplace(std::move(key)).first;
+    }
+
+    // Get the number of elements
+    size_t getSize() const 
+    {
+        return size;
+    }
+
+    // True while entries are still being moved to a bigger table
+    bool isRehashing() const 
+    {
+        return !oldBuckets.empty();
+    }
+
+    // Occupancy, chain lengths, counters and memory footprint (walks the
+    // whole table). Only instrumented tables have it.
+    HashTableStats stats() const 
+    {
+        static_assert(Instrumented, "stats() needs UnorderedMap<Key, Value, Hash, true>");
+
+        HashTableStats result;
+        result.elements = size;
+        result.buckets = bucketCount;
+        result.occupancy.assign(9, 0);
+        size_t usedBuckets = 0;
+        for (const auto* table : { &buckets, &oldBuckets }) 
+        {
+            for (const auto& bucket : *table) 
+            {
+                size_t chain = bucket.size();
+                result.occupancy[std::min(chain, result.occupancy.size() - 1)]++;
+                result.maxChain = std::max(result.maxChain, chain);
+                usedBuckets += chain > 0;
+            }
+        }
+        result.meanChain = usedBuckets ? static_cast<double>(size) / usedBuckets : 0.0;
+        this->fillCounters(result);
+
+        // A std::list node holds two links next to the Node
+        result.memoryBytes = sizeof(*this)
+            + (buckets.capacity() + oldBuckets.capacity() + nextBuckets.capacity()) * sizeof(std::list<Node>)
+            + size * (sizeof(Node) + 2 * sizeof(void*));
+        return result;
+    }
+};
+
+// Statistics are free when disabled: the counters base is empty and takes
+// no space in the table
+static_assert(std::is_empty<HashTableCounters<false>>::value,
+              "disabled counters must be an empty base");
+static_assert(sizeof(UnorderedMap<int, int>) + sizeof(HashTableCounters<true>) ==
+              sizeof(UnorderedMap<int, int, MapHash<int>, true>),
+              "disabled statistics must not change the table layout");
+
+// Open-addressing alternative to UnorderedMap (SwissTable layout).
+// Entries live directly in one slot array, next to an array of one-byte
+// control words: 0x80 for an empty slot, 0xFE for a deleted one, or the low
+// 7 bits of the entry's hash (H2) for a full one. Slots are probed 16 at a
+// time: a group of control bytes is compared against H2 with one SSE2
+// instruction, so most lookups touch one control cache line and compare at
+// most one key, and no lookup or insert allocates a list node.
 template <typename Key, typename Value>
-class UnorderedMap 
+class FlatUnorderedMap 
+{
+private:
+    struct Node 
+    {
+        Key key;
+        Value value;
+    };
+
+    static const size_t GROUP_SIZE = 16;
+    static const int8_t CTRL_EMPTY = -128;  // 0x80
+    static const int8_t CTRL_DELETED = -2;  // 0xFE
+
+    int8_t* ctrl;        // One control byte per slot
+    Node* slots;         // Uninitialized storage, constructed when full
+    size_t capacity;     // Number of slots (power of two, multiple of GROUP_SIZE)
+    size_t size;         // Number of full slots
+    size_t deleted;      // Number of tombstones
+    float loadFactor;    // Maximum (full + deleted) / capacity
+
+    // Bitmask of the slots in a group whose control byte equals h2
+    static uint32_t matchByte(const int8_t* group, int8_t h2) 
+    {
+#if defined(__SSE2__)
+        __m128i ctrlBytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8(h2)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) 
+            mask |= static_cast<uint32_t>(group[i] == h2) << i;
+        return mask;
+#endif
+    }
+
+    // Bitmask of the empty or deleted slots in a group (high bit set)
+    static uint32_t matchFree(const int8_t* group) 
+    {
+#if defined(__SSE2__)
+        return _mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) 
+            mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        return mask;
+#endif
+    }
+
+    static int lowestBit(uint32_t mask) 
+    {
+        return __builtin_ctz(mask);
+    }
+
+    size_t hashOf(const Key& key) const 
+    {
+        return mixHash(std::hash<Key>{}(key));
+    }
+
+    static int8_t h2Of(size_t hash) 
+    {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    // Index of the first group probed for a hash
+    size_t firstGroup(size_t hash) const 
+    {
+        return (hash >> 7) & (capacity / GROUP_SIZE - 1);
+    }
+
+    // Slot holding key, or capacity if absent
+    size_t findSlot(const Key& key, size_t hash) const 
+    {
+        size_t groupMask = capacity / GROUP_SIZE - 1;
+        size_t group = firstGroup(hash);
+        int8_t h2 = h2Of(hash);
+
+        // Triangular probing over groups visits every group once
+        for (size_t step = 1; step <= capacity / GROUP_SIZE; ++step) 
+        {
+            const int8_t* groupCtrl = ctrl + group * GROUP_SIZE;
+            for (uint32_t mask = matchByte(groupCtrl, h2); mask; mask &= mask - 1) 
+            {
+                size_t index = group * GROUP_SIZE + lowestBit(mask);
+                if (slots[index].key == key) 
+                {
+                    return index;
+                }
+            }
+            // An empty slot ends the probe sequence
+            if (matchByte(groupCtrl, CTRL_EMPTY)) 
+            {
+                return capacity;
+            }
+            group = (group + step) & groupMask;
+        }
+        return capacity;
+    }
+
+    // First empty or deleted slot on the probe sequence of hash
+    size_t findFreeSlot(size_t hash) const 
+    {
+        size_t groupMask = capacity / GROUP_SIZE - 1;
+        size_t group = firstGroup(hash);
+        for (size_t step = 1; ; ++step) 
+        {
+            uint32_t mask = matchFree(ctrl + group * GROUP_SIZE);
+            if (mask) 
+            {
+                return group * GROUP_SIZE + lowestBit(mask);
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Members are only replaced once both arrays exist, so a failed
+    // allocation leaves the current table untouched
+    void allocate(size_t newCapacity) 
+    {
+        int8_t* newCtrl = static_cast<int8_t*>(std::aligned_alloc(GROUP_SIZE, newCapacity));
+        if (!newCtrl) 
+        {
+            throw std::bad_alloc();
+        }
+        Node* newSlots;
+        try 
+        {
+            newSlots = std::allocator<Node>().allocate(newCapacity);
+        }
+        catch (...) 
+        {
+            std::free(newCtrl);
+            throw;
+        }
+        std::memset(newCtrl, CTRL_EMPTY, newCapacity);
+        ctrl = newCtrl;
+        slots = newSlots;
+        capacity = newCapacity;
+        size = 0;
+        deleted = 0;
+    }
+
+    void release() 
+    {
+        for (size_t i = 0; i < capacity; ++i) 
+        {
+            if (ctrl[i] >= 0) 
+            {
+                slots[i].~Node();
+            }
+        }
+        std::allocator<Node>().deallocate(slots, capacity);
+        std::free(ctrl);
+    }
+
+    // Move every entry into a fresh table; the capacity only doubles when the
+    // table is really full, otherwise this just purges tombstones
+    void rehash() 
+    {
+        size_t newCapacity = size * 2 >= capacity * loadFactor ? capacity * 2 : capacity;
+        int8_t* oldCtrl = ctrl;
+        Node* oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; ++i) 
+        {
+            if (oldCtrl[i] >= 0) 
+            {
+                size_t hash = hashOf(oldSlots[i].key);
+                size_t index = findFreeSlot(hash);
+                ctrl[index] = h2Of(hash);
+                new (&slots[index]) Node{ std::move(oldSlots[i].key), std::move(oldSlots[i].value) };
+                oldSlots[i].~Node();
+                size++;
+            }
+        }
+        std::allocator<Node>().deallocate(oldSlots, oldCapacity);
+        std::free(oldCtrl);
+    }
+
+    // Slot for key, inserting a default-constructed value if it is absent
+    size_t findOrInsert(const Key& key, bool& inserted) 
+    {
+        size_t hash = hashOf(key);
+        size_t index = findSlot(key, hash);
+        if (index != capacity) 
+        {
+            inserted = false;
+            return index;
+        }
+
+        if (static_cast<float>(size + deleted + 1) > capacity * loadFactor) 
+        {
+            rehash();
+        }
+
+        // Construct first: if Key or Value throws, the slot is still free
+        index = findFreeSlot(hash);
+        new (&slots[index]) Node{ key, Value{} };
+        if (ctrl[index] == CTRL_DELETED) 
+        {
+            deleted--;
+        }
+        ctrl[index] = h2Of(hash);
+        size++;
+        inserted = true;
+        return index;
+    }
+
+public:
+    // Constructor (capacity is rounded up to a power of two, at least one group).
+    // The load factor is clamped to [0.25, 0.9375]: a full table would leave
+    // probes without an empty slot to stop at.
+    FlatUnorderedMap(size_t initialCapacity = 16, float maxLoadFactor = 0.875)
+        : loadFactor(!(maxLoadFactor >= 0.25f) ? 0.25f : std::min(maxLoadFactor, 0.9375f)) {
+        size_t cap = GROUP_SIZE;
+        while (cap < initialCapacity) cap *= 2;
+        allocate(cap);
+    }
+
+    FlatUnorderedMap(const FlatUnorderedMap&) = delete;
+    FlatUnorderedMap& operator=(const FlatUnorderedMap&) = delete;
+
+    ~FlatUnorderedMap() 
+    {
+        release();
+    }
+
+    // Insert or update a key-value pair
+    void insert(const Key& key, const Value& value) 
+    {
+        bool inserted;
+        size_t index = findOrInsert(key, inserted); // may rehash, so look up slots afterwards
+        slots[index].value = value;
+    }
+
+    // Find a value by key
+    Value* find(const Key& key) 
+    {
+        size_t index = findSlot(key, hashOf(key));
+        return index == capacity ? nullptr : &slots[index].value;
+    }
+
+    // Erase a key-value pair by key
+    void erase(const Key& key) 
+    {
+        size_t index = findSlot(key, hashOf(key));
+        if (index == capacity) 
+        {
+            return;
+        }
+
+        slots[index].~Node();
+        // If the group still has an empty slot no probe ever continued past
+        // it, so the slot can become empty again instead of a tombstone
+        if (matchByte(ctrl + index / GROUP_SIZE * GROUP_SIZE, CTRL_EMPTY)) 
+        {
+            ctrl[index] = CTRL_EMPTY;
+        }
+        else 
+        {
+            ctrl[index] = CTRL_DELETED;
+            deleted++;
+        }
+        size--;
+    }
+
+    // Access or insert a key-value pair using []
+    Value& operator[](const Key& key) 
+    {
+        bool inserted;
+        size_t index = findOrInsert(key, inserted);
+        return slots[index].value;
+    }
+
+    // Get the number of elements
+    size_t getSize() const 
+    {
+        return size;
+    }
+};
+
+// Thread-safe UnorderedMap split into independently locked shards. The top
+// bits of a key's hash pick its shard (the bucket index inside a shard uses
+// the low bits), so threads working on different shards never contend.
+// Lookups take a shard's lock shared, writers take it exclusively, and a
+// shard that outgrows its table rehashes on its own while all other shards
+// stay available: there is no global stop for resizing.
+template <typename Key, typename Value, typename Hash = MapHash<Key>>
+class ConcurrentUnorderedMap 
+{
+private:
+    // Each shard on its own cache line(s), so locks do not false-share
+    struct alignas(64) Shard 
+    {
+        mutable std::shared_mutex mutex;
+        UnorderedMap<Key, Value, Hash> map;
+    };
+
+    std::vector<Shard> shards;
+    unsigned shardBits;
+
+    template <typename K>
+    Shard& shardFor(const K& key) 
+    {
+        return shards[shardBits ? mixHash(Hash{}(key)) >> (64 - shardBits) : 0];
+    }
+
+    template <typename K>
+    const Shard& shardFor(const K& key) const 
+    {
+        return shards[shardBits ? mixHash(Hash{}(key)) >> (64 - shardBits) : 0];
+    }
+
+public:
+    // Constructor (shard count is rounded up to a power of two)
+    explicit ConcurrentUnorderedMap(size_t shardCount = 64)
+        : shardBits(0) {
+        while ((size_t(1) << shardBits) < shardCount) shardBits++;
+        shards = std::vector<Shard>(size_t(1) << shardBits);
+    }
+
+    // Copy of the value for key, if present
+    std::optional<Value> find(const Key& key) const 
+    {
+        const Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const Value* value = shard.map.find(key);
+        return value ? std::optional<Value>(*value) : std::nullopt;
+    }
+
+    // Insert or update a key-value pair; returns true if the key was new
+    bool insert(const Key& key, const Value& value) 
+    {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.insert_or_assign(key, value).second;
+    }
+
+    // Erase a key; returns whether it was present
+    bool erase(const Key& key) 
+    {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.erase(key);
+    }
+
+    // Atomically return the value for key, inserting make() first if the key
+    // is absent. make runs under the shard lock, at most once per key.
+    template <typename F>
+    Value compute_if_absent(const Key& key, F&& make) 
+    {
+        Shard& shard = shardFor(key);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            if (const Value* value = std::as_const(shard.map).find(key)) 
+            {
+                return *value;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (Value* value = shard.map.find(key)) 
+        {
+            return *value; // another thread won the race
+        }
+        return *shard.map.try_emplace(key, make()).first;
+    }
+
+    // Atomically apply fn(Value&) to the value for key; false if absent
+    template <typename F>
+    bool update(const Key& key, F&& fn) 
+    {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        Value* value = shard.map.find(key);
+        if (!value) 
+        {
+            return false;
+        }
+        fn(*value);
+        return true;
+    }
+
+    // Number of elements (a snapshot that may be stale under concurrent writes)
+    size_t getSize() const 
+    {
+        size_t total = 0;
+        for (const Shard& shard : shards) 
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            total += shard.map.getSize();
+        }
+        return total;
+    }
+};
+
+// UnorderedMap from strings to Value that lives in a memory-mapped file, so
+// a process can reopen a big table in about the time it takes to map it
+// instead of rebuilding it. Everything in the file refers to everything
+// else by offset from the start of the mapping, never by pointer, so the
+// file works wherever it is mapped. Layout: a Header, then a bump-allocated
+// arena holding the bucket arrays, their Table records and the entries;
+// each entry is followed by its key's bytes. Lookups read the mapping
+// directly (zero-copy). Erased and replaced entries and old bucket arrays
+// stay in the file as garbage.
+// Writes go to the shared mapping, so a later open sees them even without
+// checkpoint(); checkpoint() msyncs the file, which makes them survive a
+// crash of the machine. Every change, updates included, is written in full
+// before a single 8-byte store links it in, so a process that dies
+// mid-insert or mid-rehash leaves a file that still opens with all linked
+// entries. The size is flagged while it changes and recounted on open if
+// the flag is still set; a file whose creation never finished is created
+// again.
+// Entries store std::hash values, so the file is only portable between
+// builds that use the same standard library.
+template <typename Value>
+class MappedUnorderedMap 
+{
+private:
+    static_assert(std::is_trivially_copyable<Value>::value,
+                  "values are stored as raw bytes in the file");
+    static_assert(alignof(Value) <= 8, "entries are placed at 8-byte aligned offsets");
+
+    static constexpr uint64_t MAGIC = 0x3370614D64657070ull; // "ppedMap3"
+
+    struct Header 
+    {
+        uint64_t magic;         // Written last when a file is created
+        uint64_t valueSize;
+        uint64_t fileSize;      // May lag behind the real size after a crash while growing
+        uint64_t used;          // End of the allocated part of the arena
+        uint64_t table;         // Offset of the current Table
+        uint64_t size;
+        uint64_t sizePending;   // Set while an insert or erase links or unlinks an entry
+    };
+
+    // A bucket array and which of the entries' two links its chains use.
+    // Rehashing threads the entries into a new Table through the other
+    // link, leaving the current chains untouched until Header::table
+    // switches over.
+    struct Table 
+    {
+        uint64_t bucketsOffset;
+        uint64_t bucketCount;   // Power of two
+        uint64_t link;          // Index into Entry::next
+    };
+
+    struct Entry 
+    {
+        uint64_t hash;
+        uint64_t next[2];       // Offset of the next entry in the bucket, 0 = none
+        uint64_t keyLength;
+        Value value;
+    };
+
+    int fd;
+    char* base;
+    size_t mappedBytes;
+
+    Header& header() const 
+    {
+        return *reinterpret_cast<Header*>(base);
+    }
+
+    Table& table() const 
+    {
+        return *reinterpret_cast<Table*>(base + header().table);
+    }
+
+    Entry& entryAt(uint64_t offset) const 
+    {
+        return *reinterpret_cast<Entry*>(base + offset);
+    }
+
+    uint64_t* bucketArray() const 
+    {
+        return reinterpret_cast<uint64_t*>(base + table().bucketsOffset);
+    }
+
+    uint64_t& linkAt(uint64_t offset) const 
+    {
+        return *reinterpret_cast<uint64_t*>(base + offset);
+    }
+
+    static std::string_view keyOf(const Entry& entry) 
+    {
+        return std::string_view(reinterpret_cast<const char*>(&entry + 1), entry.keyLength);
+    }
+
+    static size_t hashOf(std::string_view key) 
+    {
+        return mixHash(std::hash<std::string_view>{}(key));
+    }
+
+    // Store the offset that makes already written data reachable. The fence
+    // keeps the compiler from moving the data's stores after it; a killed
+    // process has executed its stores in program order, and only another
+    // process reading concurrently would need a CPU fence.
+    static void publish(uint64_t& link, uint64_t offset) 
+    {
+        std::atomic_signal_fence(std::memory_order_release);
+        link = offset;
+    }
+
+    // Flag or clear a size change. The compiler fences on both sides keep
+    // the link store and the size update between the two flag stores.
+    void markSizePending(uint64_t pending) 
+    {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        header().sizePending = pending;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    // Map bytes of the file; the old mapping is only dropped once the new
+    // one exists, so a failure leaves the map as it was
+    void map(size_t bytes) 
+    {
+        void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) 
+        {
+            throw std::runtime_error("mmap failed");
+        }
+        if (base) 
+        {
+            munmap(base, mappedBytes);
+        }
+        base = static_cast<char*>(address);
+        mappedBytes = bytes;
+    }
+
+    // Reserve bytes in the arena, growing the file (and remapping it) if
+    // needed. Returns the offset; existing offsets stay valid.
+    uint64_t allocate(size_t bytes) 
+    {
+        bytes = (bytes + 7) & ~size_t(7);
+        uint64_t offset = header().used;
+        if (offset + bytes > header().fileSize) 
+        {
+            size_t newSize = header().fileSize;
+            while (offset + bytes > newSize) newSize *= 2;
+            if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) 
+            {
+                throw std::runtime_error("cannot grow the map file");
+            }
+            map(newSize);
+            header().fileSize = newSize;
+        }
+        header().used = offset + bytes;
+        return offset;
+    }
+
+    // Offset of the link that holds key's entry, or of the 0 that ends
+    // its chain when key is absent. An offset rather than a pointer, so it
+    // survives the remap of a growing file.
+    uint64_t findLink(std::string_view key, size_t hash) const 
+    {
+        const Table& current = table();
+        uint64_t link = current.bucketsOffset + (hash & (current.bucketCount - 1)) * sizeof(uint64_t);
+        while (uint64_t offset = linkAt(link)) 
+        {
+            const Entry& entry = entryAt(offset);
+            if (entry.hash == hash && keyOf(entry) == key) 
+            {
+                return link;
+            }
+            link = reinterpret_cast<const char*>(&entry.next[current.link]) - base;
+        }
+        return link;
+    }
+
+    // Thread every entry into a bucket array twice as big (hashes are
+    // cached in the entries, so no key is read). Only the spare link of
+    // each entry is written; the switch to the new table is one store.
+    void rehash() 
+    {
+        uint64_t oldCount = table().bucketCount;
+        uint64_t newCount = oldCount * 2;
+        uint64_t newOffset = allocate(newCount * sizeof(uint64_t));
+        uint64_t tableOffset = allocate(sizeof(Table)); // both may remap: take pointers afterwards
+
+        uint64_t oldLink = table().link;
+        uint64_t newLink = 1 - oldLink;
+        uint64_t* newBuckets = reinterpret_cast<uint64_t*>(base + newOffset);
+        std::fill(newBuckets, newBuckets + newCount, 0);
+
+        uint64_t* oldBuckets = bucketArray();
+        for (uint64_t i = 0; i < oldCount; i++) 
+        {
+            for (uint64_t offset = oldBuckets[i]; offset != 0; offset = entryAt(offset).next[oldLink]) 
+            {
+                Entry& entry = entryAt(offset);
+                uint64_t& head = newBuckets[entry.hash & (newCount - 1)];
+                entry.next[newLink] = head;
+                head = offset;
+            }
+        }
+
+        *reinterpret_cast<Table*>(base + tableOffset) = Table{ newOffset, newCount, newLink };
+        publish(header().table, tableOffset);
+    }
+
+    // Count the linked entries again, checking that every entry lies
+    // inside the arena and that no chain loops; false if one does not
+    bool recountSize() 
+    {
+        const Table& current = table();
+        uint64_t used = header().used;
+        uint64_t limit = used / sizeof(Entry);
+        uint64_t count = 0;
+        for (uint64_t i = 0; i < current.bucketCount; i++) 
+        {
+            for (uint64_t offset = bucketArray()[i]; offset != 0; offset = entryAt(offset).next[current.link]) 
+            {
+                if (offset < sizeof(Header) || offset % 8 != 0 || offset > used || used - offset < sizeof(Entry) ||
+                    entryAt(offset).keyLength > used - offset - sizeof(Entry) || ++count > limit) 
+                {
+                    return false;
+                }
+            }
+        }
+        header().size = count;
+        markSizePending(0);
+        return true;
+    }
+
+    // Map an existing file, checking that it is a complete map of this
+    // value type; false if its creation never finished (magic still 0).
+    // A crash while growing can leave the file longer than the header
+    // says; that tail was never handed out and is adopted.
+    bool openExisting(const std::string& path, size_t bytes) 
+    {
+        map(bytes);
+        if (mappedBytes < sizeof(Header) || header().magic == 0) 
+        {
+            return false;
+        }
+        const Header& h = header();
+        bool valid = h.magic == MAGIC && h.valueSize == sizeof(Value) && h.fileSize <= mappedBytes &&
+                     h.used <= h.fileSize && h.used >= sizeof(Header) + sizeof(Table) &&
+                     h.table >= sizeof(Header) && h.table % 8 == 0 &&
+                     h.table <= h.used - sizeof(Table);
+        if (valid) 
+        {
+            const Table& t = table();
+            valid = t.link <= 1 && t.bucketCount != 0 && (t.bucketCount & (t.bucketCount - 1)) == 0 &&
+                    t.bucketsOffset >= sizeof(Header) && t.bucketsOffset % 8 == 0 && t.bucketsOffset <= h.used &&
+                    t.bucketCount <= (h.used - t.bucketsOffset) / sizeof(uint64_t);
+        }
+        if (valid && header().sizePending) 
+        {
+            valid = recountSize();
+        }
+        if (!valid) 
+        {
+            throw std::runtime_error(path + " is not a map of this value type");
+        }
+        header().fileSize = mappedBytes;
+        return true;
+    }
+
+    // Lay out an empty map in a new (zero-filled) file
+    void create(const std::string& path, size_t initialBucketCount) 
+    {
+        uint64_t bucketCount = 1;
+        while (bucketCount < initialBucketCount) bucketCount *= 2;
+        size_t bytes = 4096;
+        while (bytes < sizeof(Header) + sizeof(Table) + bucketCount * sizeof(uint64_t)) bytes *= 2;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) 
+        {
+            throw std::runtime_error("cannot size " + path);
+        }
+        map(bytes);
+        header() = Header{ 0, sizeof(Value), bytes, sizeof(Header), 0, 0, 0 };
+        uint64_t bucketsOffset = allocate(bucketCount * sizeof(uint64_t));
+        uint64_t* buckets = reinterpret_cast<uint64_t*>(base + bucketsOffset);
+        std::fill(buckets, buckets + bucketCount, 0); // The file may be a half-created one
+        header().table = allocate(sizeof(Table));
+        table() = Table{ bucketsOffset, bucketCount, 0 };
+        publish(header().magic, MAGIC);
+    }
+
+public:
+    // Open the map stored at path, or create an empty one there
+    explicit MappedUnorderedMap(const std::string& path, size_t initialBucketCount = 1024)
+        : fd(-1), base(nullptr), mappedBytes(0) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) 
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+
+        // The destructor does not run if this throws, so clean up here
+        try 
+        {
+            struct stat info;
+            if (fstat(fd, &info) != 0) 
+            {
+                throw std::runtime_error("cannot stat " + path);
+            }
+            if (info.st_size == 0 || !openExisting(path, static_cast<size_t>(info.st_size))) 
+            {
+                create(path, initialBucketCount);
+            }
+        }
+        catch (...) 
+        {
+            if (base) 
+            {
+                munmap(base, mappedBytes);
+            }
+            ::close(fd);
+            throw;
+        }
+    }
+
+    MappedUnorderedMap(const MappedUnorderedMap&) = delete;
+    MappedUnorderedMap& operator=(const MappedUnorderedMap&) = delete;
+
+    ~MappedUnorderedMap() 
+    {
+        munmap(base, mappedBytes);
+        ::close(fd);
+    }
+
+    // Insert or update a key-value pair
+    void insert(std::string_view key, const Value& value) 
+    {
+        size_t hash = hashOf(key);
+        uint64_t link = findLink(key, hash);
+        uint64_t existing = linkAt(link);
+
+        // Write the entry completely before linking it in. An update writes
+        // a new entry as well and swaps it for the old one in the chain, so
+        // no value is ever left half overwritten.
+        uint64_t offset = allocate(sizeof(Entry) + key.size());
+        Entry& entry = entryAt(offset);
+        entry.hash = hash;
+        entry.keyLength = key.size();
+        entry.value = value;
+        std::memcpy(&entry + 1, key.data(), key.size());
+
+        const Table& current = table();
+        if (existing) 
+        {
+            entry.next[current.link] = entryAt(existing).next[current.link];
+            publish(linkAt(link), offset);
+            return;
+        }
+        entry.next[current.link] = 0; // Appended where the chain ended
+        markSizePending(1);
+        publish(linkAt(link), offset);
+        header().size++;
+        markSizePending(0);
+
+        if (header().size * 4 > current.bucketCount * 3) 
+        {
+            rehash();
+        }
+    }
+
+    // Value for key, read in place from the mapping (valid until the next insert)
+    const Value* find(std::string_view key) const 
+    {
+        uint64_t offset = linkAt(findLink(key, hashOf(key)));
+        return offset ? &entryAt(offset).value : nullptr;
+    }
+
+    // Unlink a key; returns whether it was present
+    bool erase(std::string_view key) 
+    {
+        uint64_t link = findLink(key, hashOf(key));
+        uint64_t offset = linkAt(link);
+        if (offset == 0) 
+        {
+            return false;
+        }
+        markSizePending(1);
+        linkAt(link) = entryAt(offset).next[table().link];
+        header().size--;
+        markSizePending(0);
+        return true;
+    }
+
+    // Flush every change to disk
+    void checkpoint() 
+    {
+        if (msync(base, mappedBytes, MS_SYNC) != 0) 
+        {
+            throw std::runtime_error("msync failed");
+        }
+    }
+
+    size_t getSize() const 
+    {
+        return header().size;
+    }
+
+    size_t fileSize() const 
+    {
+        return header().fileSize;
+    }
+};
+
+// Minimal perfect hashing for key sets that are fixed once built (opcodes,
+// header names, ...). CHD-style "hash and displace": keys are grouped into
+// about n/2 buckets by one part of their hash, and every bucket gets a seed
+// chosen so that all of its keys land in distinct free slots of an n-slot
+// table. Buckets are placed biggest first, while the table is still
+// empty. A lookup is then one string hash, one seed load and one key
+// compare: no chains and no probing.
+
+// Little-endian 8-byte read that also works in constant expressions (no
+// memcpy there); compilers turn the shifts into one load
+constexpr uint64_t perfectWordAt(const char* p) 
+{
+    using u = unsigned char;
+    return uint64_t(u(p[0])) | uint64_t(u(p[1])) << 8 | uint64_t(u(p[2])) << 16 | uint64_t(u(p[3])) << 24 |
+           uint64_t(u(p[4])) << 32 | uint64_t(u(p[5])) << 40 | uint64_t(u(p[6])) << 48 | uint64_t(u(p[7])) << 56;
+}
+
+// String hash usable at compile time: 8 bytes per step, then a
+// murmur-style finalizer
+constexpr uint64_t perfectHashOf(std::string_view key) 
+{
+    auto byteAt = [key](size_t pos) {
+        return static_cast<uint64_t>(static_cast<unsigned char>(key[pos]));
+    };
+    auto wordAt = [key](size_t pos) {
+        return perfectWordAt(key.data() + pos);
+    };
+
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (key.size() * 0xC2B2AE3D27D4EB4Full);
+    size_t pos = 0;
+    for (; pos + 8 <= key.size(); pos += 8) 
+    {
+        h = (h ^ wordAt(pos)) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 29;
+    }
+
+    // Remaining bytes: the last 8 bytes of the key (overlapping the loop's)
+    // when it has that many, else byte by byte
+    uint64_t tail = 0;
+    if (pos < key.size() && key.size() >= 8) 
+    {
+        tail = wordAt(key.size() - 8);
+    }
+    else 
+    {
+        for (size_t i = 0; pos + i < key.size(); i++) tail |= byteAt(pos + i) << (8 * i);
+    }
+    h = (h ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+}
+
+constexpr size_t perfectBucketCount(size_t keyCount) 
+{
+    return keyCount / 2 + 1;
+}
+
+constexpr size_t perfectBucketOf(uint64_t hash, size_t bucketCount) 
+{
+    return static_cast<size_t>(((hash & 0xFFFFFFFFull) * bucketCount) >> 32);
+}
+
+constexpr size_t perfectSlotOf(uint64_t hash, uint32_t seed, size_t slotCount) 
+{
+    uint64_t x = hash + seed * 0x9E3779B97F4A7C15ull;
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 32;
+    return static_cast<size_t>(((x & 0xFFFFFFFFull) * slotCount) >> 32);
+}
+
+// Find a seed for every bucket and the slot of every key. Written against
+// any indexable containers, so the same code runs at compile time on
+// std::arrays and at startup on std::vectors. Throws (a compile error in a
+// constant expression) if two keys hash identically, e.g. duplicates.
+template <typename Hashes, typename Seeds, typename Slots, typename Scratch>
+constexpr void buildPerfectHash(const Hashes& hashes, size_t n, Seeds& seeds, Slots& slotOfKey,
+                                Scratch& bucketStart, Scratch& keysByBucket, Scratch& order, Scratch& taken) 
+{
+    size_t bucketCount = perfectBucketCount(n);
+
+    // Group key indices by bucket (counting sort)
+    for (size_t b = 0; b <= bucketCount; b++) bucketStart[b] = 0;
+    for (size_t i = 0; i < n; i++) bucketStart[perfectBucketOf(hashes[i], bucketCount) + 1]++;
+    for (size_t b = 0; b < bucketCount; b++) bucketStart[b + 1] += bucketStart[b];
+    for (size_t b = 0; b < bucketCount; b++) order[b] = bucketStart[b];
+    for (size_t i = 0; i < n; i++) keysByBucket[order[perfectBucketOf(hashes[i], bucketCount)]++] = i;
+
+    // Keys with identical hashes share a bucket and no seed can separate
+    // them, so reject them here rather than after a hopeless seed search
+    for (size_t b = 0; b < bucketCount; b++) 
+    {
+        for (size_t i = bucketStart[b]; i < bucketStart[b + 1]; i++) 
+        {
+            for (size_t j = i + 1; j < bucketStart[b + 1]; j++) 
+            {
+                if (hashes[keysByBucket[i]] == hashes[keysByBucket[j]]) 
+                {
+                    throw std::runtime_error("perfect hash: keys with identical hashes (duplicate keys?)");
+                }
+            }
+        }
+    }
+
+    // Buckets by decreasing size (counting sort again; sizes are small)
+    size_t maxSize = 0;
+    for (size_t b = 0; b < bucketCount; b++) 
+    {
+        maxSize = std::max(maxSize, static_cast<size_t>(bucketStart[b + 1] - bucketStart[b]));
+    }
+    size_t placed = 0;
+    for (size_t size = maxSize; size > 0; size--) 
+    {
+        for (size_t b = 0; b < bucketCount; b++) 
+        {
+            if (bucketStart[b + 1] - bucketStart[b] == size) order[placed++] = b;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) taken[i] = 0;
+    for (size_t b = 0; b < bucketCount; b++) seeds[b] = 0;
+
+    for (size_t p = 0; p < placed; p++) 
+    {
+        size_t b = order[p];
+        size_t first = bucketStart[b], last = bucketStart[b + 1];
+        for (uint32_t seed = 0; ; seed++) 
+        {
+            if (seed == (1u << 24)) 
+            {
+                throw std::runtime_error("perfect hash: no seed separates a bucket's keys");
+            }
+
+            // Claim the slots one by one, releasing them again on a clash
+            size_t claimed = first;
+            for (; claimed < last; claimed++) 
+            {
+                size_t slot = perfectSlotOf(hashes[keysByBucket[claimed]], seed, n);
+                if (taken[slot]) break;
+                taken[slot] = 1;
+                slotOfKey[keysByBucket[claimed]] = slot;
+            }
+            if (claimed == last) 
+            {
+                seeds[b] = seed;
+                break;
+            }
+            for (size_t k = first; k < claimed; k++) taken[slotOfKey[keysByBucket[k]]] = 0;
+        }
+    }
+}
+
+// Perfect hash map from a key list known at compile time. Build it with
+// makeStaticPerfectHashMap; lookups work in constant expressions too.
+template <typename Value, size_t N>
+class StaticPerfectHashMap 
+{
+private:
+    std::array<uint32_t, perfectBucketCount(N)> seeds{};
+    std::array<std::string_view, N> keys{};
+    std::array<Value, N> values{};
+
+    template <typename V, size_t M>
+    friend constexpr StaticPerfectHashMap<V, M> makeStaticPerfectHashMap(const std::pair<std::string_view, V> (&)[M]);
+
+public:
+    // Value for key, or nullptr: one hash and one compare
+    constexpr const Value* find(std::string_view key) const 
+    {
+        uint64_t hash = perfectHashOf(key);
+        size_t slot = perfectSlotOf(hash, seeds[perfectBucketOf(hash, seeds.size())], N);
+        return keys[slot] == key ? &values[slot] : nullptr;
+    }
+
+    constexpr size_t getSize() const 
+    {
+        return N;
+    }
+};
+
+template <typename Value, size_t N>
+constexpr StaticPerfectHashMap<Value, N> makeStaticPerfectHashMap(const std::pair<std::string_view, Value> (&entries)[N]) 
+{
+    std::array<uint64_t, N> hashes{};
+    for (size_t i = 0; i < N; i++) hashes[i] = perfectHashOf(entries[i].first);
+
+    constexpr size_t B = perfectBucketCount(N);
+    std::array<size_t, N> slotOfKey{};
+    std::array<size_t, (N > B ? N : B) + 1> bucketStart{}, keysByBucket{}, order{}, taken{};
+    StaticPerfectHashMap<Value, N> map;
+    buildPerfectHash(hashes, N, map.seeds, slotOfKey, bucketStart, keysByBucket, order, taken);
+
+    for (size_t i = 0; i < N; i++) 
+    {
+        map.keys[slotOfKey[i]] = entries[i].first;
+        map.values[slotOfKey[i]] = entries[i].second;
+    }
+    return map;
+}
+
+// The same for keys only known at startup (e.g. loaded from a file). The
+// map owns copies of the keys and cannot change once built.
+template <typename Value>
+class PerfectHashMap 
+{
+private:
+    std::vector<uint32_t> seeds;
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+
+public:
+    explicit PerfectHashMap(const std::vector<std::pair<std::string, Value>>& entries) 
+    {
+        size_t n = entries.size();
+        std::vector<uint64_t> hashes(n);
+        for (size_t i = 0; i < n; i++) hashes[i] = perfectHashOf(entries[i].first);
+
+        size_t scratchSize = std::max(n, perfectBucketCount(n)) + 1;
+        std::vector<size_t> slotOfKey(n);
+        std::vector<size_t> bucketStart(scratchSize), keysByBucket(scratchSize), order(scratchSize), taken(scratchSize);
+        seeds.resize(perfectBucketCount(n));
+        buildPerfectHash(hashes, n, seeds, slotOfKey, bucketStart, keysByBucket, order, taken);
+
+        keys.resize(n);
+        values.resize(n);
+        for (size_t i = 0; i < n; i++) 
+        {
+            keys[slotOfKey[i]] = entries[i].first;
+            values[slotOfKey[i]] = entries[i].second;
+        }
+    }
+
+    // Value for key, or nullptr: one hash and one compare
+    const Value* find(std::string_view key) const 
+    {
+        if (keys.empty()) 
+        {
+            return nullptr;
+        }
+        uint64_t hash = perfectHashOf(key);
+        size_t slot = perfectSlotOf(hash, seeds[perfectBucketOf(hash, seeds.size())], keys.size());
+        return keys[slot] == key ? &values[slot] : nullptr;
+    }
+
+    size_t getSize() const 
+    {
+        return keys.size();
+    }
+};
+
+// Compile-time example: the table is built by the compiler and checked here
+constexpr std::pair<std::string_view, int> OPCODES[] = {
+    { "nop", 0 }, { "load", 1 }, { "store", 2 }, { "add", 3 }, { "sub", 4 },
+    { "mul", 5 }, { "div", 6 }, { "jmp", 7 }, { "jz", 8 }, { "call", 9 },
+    { "ret", 10 }, { "push", 11 }, { "pop", 12 } };
+constexpr auto opcodeTable = makeStaticPerfectHashMap(OPCODES);
+static_assert(*opcodeTable.find("mul") == 5 && opcodeTable.find("halt") == nullptr,
+              "perfect hash lookups work at compile time");
+
+// Eviction policies for BoundedCache. A policy tracks the cache's entries by
+// slot number and decides which one to evict next:
+//   onInsert(slot, hash)  a new entry was stored in slot
+//   onHit(slot, hash)     the entry in slot was read or overwritten
+//   onErase(slot)         the entry in slot is gone (erased or evicted)
+//   victim()              slot to evict next (the cache is not empty)
+// All of them are O(1) (CLOCK amortized).
+
+// Doubly linked lists threaded through per-slot prev/next arrays, so moving
+// an entry costs no allocation. Indices below listCount are the lists' head
+// sentinels; slot s is node s + listCount.
+template <uint32_t listCount>
+struct SlotLists 
+{
+    std::vector<uint32_t> prev, next;
+    uint32_t sizes[listCount] = {};
+
+    SlotLists() : prev(listCount), next(listCount) 
+    {
+        for (uint32_t list = 0; list < listCount; list++) 
+        {
+            prev[list] = next[list] = list;
+        }
+    }
+
+    // Link slot at the front (most recently used end) of list
+    void pushFront(uint32_t list, uint32_t slot) 
+    {
+        uint32_t node = slot + listCount;
+        if (node >= next.size()) 
+        {
+            prev.resize(node + 1);
+            next.resize(node + 1);
+        }
+        prev[node] = list;
+        next[node] = next[list];
+        prev[next[list]] = node;
+        next[list] = node;
+        sizes[list]++;
+    }
+
+    void unlink(uint32_t list, uint32_t slot) 
+    {
+        uint32_t node = slot + listCount;
+        next[prev[node]] = next[node];
+        prev[next[node]] = prev[node];
+        sizes[list]--;
+    }
+
+    // Least recently used slot of a non-empty list
+    uint32_t back(uint32_t list) const 
+    {
+        return prev[list] - listCount;
+    }
+};
+
+// Least recently used
+class LruPolicy 
+{
+private:
+    SlotLists<1> lists;
+
+public:
+    void onInsert(uint32_t slot, size_t) 
+    {
+        lists.pushFront(0, slot);
+    }
+
+    void onHit(uint32_t slot, size_t) 
+    {
+        lists.unlink(0, slot);
+        lists.pushFront(0, slot);
+    }
+
+    void onErase(uint32_t slot) 
+    {
+        lists.unlink(0, slot);
+    }
+
+    uint32_t victim() const 
+    {
+        return lists.back(0);
+    }
+};
+
+// CLOCK (second chance): a hit only sets a reference bit, so reads never
+// touch shared list pointers; the hand clears bits until it finds an entry
+// that was not referenced since its last pass
+class ClockPolicy 
+{
+private:
+    enum : uint8_t { FREE, LIVE, REFERENCED };
+    std::vector<uint8_t> state;
+    size_t hand = 0;
+
+public:
+    void onInsert(uint32_t slot, size_t) 
+    {
+        if (slot >= state.size()) 
+        {
+            state.resize(slot + 1, FREE);
+        }
+        state[slot] = LIVE;
+    }
+
+    void onHit(uint32_t slot, size_t) 
+    {
+        state[slot] = REFERENCED;
+    }
+
+    void onErase(uint32_t slot) 
+    {
+        state[slot] = FREE;
+    }
+
+    uint32_t victim() 
+    {
+        while (true) 
+        {
+            if (hand >= state.size()) 
+            {
+                hand = 0;
+            }
+            if (state[hand] == LIVE) 
+            {
+                return static_cast<uint32_t>(hand++);
+            }
+            if (state[hand] == REFERENCED) 
+            {
+                state[hand] = LIVE;
+            }
+            hand++;
+        }
+    }
+};
+
+// Approximate access counts for W-TinyLFU: a count-min sketch with four rows
+// of counters that saturate at 15. Once 10 * width accesses were recorded
+// every counter is halved, so old popularity fades.
+class FrequencySketch 
+{
+private:
+    std::vector<uint8_t> counters; // 4 rows of width counters
+    size_t width;
+    unsigned shift;
+    size_t additions;
+
+    size_t index(size_t hash, size_t row) const 
+    {
+        static const uint64_t seeds[4] = {
+            0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+            0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull };
+        return row * width + static_cast<size_t>((hash * seeds[row]) >> shift);
+    }
+
+public:
+    FrequencySketch() { resize(64); }
+
+    // Start over with room for about entries distinct keys (a power of two)
+    void resize(size_t entries) 
+    {
+        width = 64;
+        shift = 58;
+        while (width < entries) 
+        {
+            width *= 2;
+            shift--;
+        }
+        counters.assign(4 * width, 0);
+        additions = 0;
+    }
+
+    size_t getWidth() const 
+    {
+        return width;
+    }
+
+    void increment(size_t hash) 
+    {
+        for (size_t row = 0; row < 4; row++) 
+        {
+            uint8_t& counter = counters[index(hash, row)];
+            if (counter < 15) counter++;
+        }
+        if (++additions >= 10 * width) 
+        {
+            for (uint8_t& counter : counters) counter >>= 1;
+            additions /= 2;
+        }
+    }
+
+    unsigned frequency(size_t hash) const 
+    {
+        unsigned estimate = 15;
+        for (size_t row = 0; row < 4; row++) 
+        {
+            estimate = std::min<unsigned>(estimate, counters[index(hash, row)]);
+        }
+        return estimate;
+    }
+};
+
+// W-TinyLFU: new entries enter a small LRU window (1% of the entries). An
+// entry pushed out of the window only gets into the main cache if the
+// sketch says it is used more often than the main cache's own eviction
+// candidate, so one-off keys (scans) cannot flush popular ones. The main
+// cache is a segmented LRU: a hit in probation promotes an entry to the
+// protected segment (80% of the main cache).
+class TinyLfuPolicy 
+{
+private:
+    enum : uint32_t { WINDOW, PROBATION, PROTECTED };
+    SlotLists<3> lists;
+    std::vector<uint8_t> where;  // List each slot is in
+    std::vector<size_t> hashes;  // Hash of each slot's key
+    FrequencySketch sketch;
+
+    size_t liveCount() const 
+    {
+        return lists.sizes[WINDOW] + lists.sizes[PROBATION] + lists.sizes[PROTECTED];
+    }
+
+    void move(uint32_t slot, uint32_t list) 
+    {
+        lists.unlink(where[slot], slot);
+        lists.pushFront(list, slot);
+        where[slot] = static_cast<uint8_t>(list);
+    }
+
+    uint32_t mainVictim() const 
+    {
+        return lists.back(lists.sizes[PROBATION] ? PROBATION : PROTECTED);
+    }
+
+public:
+    void onInsert(uint32_t slot, size_t hash) 
+    {
+        if (slot >= where.size()) 
+        {
+            where.resize(slot + 1);
+            hashes.resize(slot + 1);
+        }
+        lists.pushFront(WINDOW, slot);
+        where[slot] = WINDOW;
+        hashes[slot] = hash;
+
+        // Keep the sketch about as wide as the cache holds entries
+        if (liveCount() > sketch.getWidth()) 
+        {
+            sketch.resize(liveCount() * 2);
+        }
+        sketch.increment(hash);
+    }
+
+    void onHit(uint32_t slot, size_t hash) 
+    {
+        sketch.increment(hash);
+        if (where[slot] != PROBATION) 
+        {
+            move(slot, where[slot]);
+            return;
+        }
+
+        move(slot, PROTECTED);
+        size_t mainCount = lists.sizes[PROBATION] + lists.sizes[PROTECTED];
+        if (lists.sizes[PROTECTED] > mainCount * 4 / 5) 
+        {
+            move(lists.back(PROTECTED), PROBATION);
+        }
+    }
+
+    void onErase(uint32_t slot) 
+    {
+        lists.unlink(where[slot], slot);
+    }
+
+    uint32_t victim() 
+    {
+        // Until the cache first fills up everything lands in the window;
+        // that surplus moves to the main cache without a contest
+        size_t windowTarget = std::max<size_t>(1, liveCount() / 100);
+        while (lists.sizes[WINDOW] > windowTarget + 1) 
+        {
+            move(lists.back(WINDOW), PROBATION);
+        }
+
+        if (lists.sizes[WINDOW] == liveCount()) 
+        {
+            return lists.back(WINDOW);
+        }
+        if (lists.sizes[WINDOW] <= windowTarget) 
+        {
+            return mainVictim();
+        }
+
+        // The window is over its share: its oldest entry competes with the
+        // main cache's victim and the less frequently used one is evicted
+        uint32_t candidate = lists.back(WINDOW);
+        uint32_t victim = mainVictim();
+        if (sketch.frequency(hashes[candidate]) > sketch.frequency(hashes[victim])) 
+        {
+            move(candidate, PROBATION);
+            return victim;
+        }
+        return candidate;
+    }
+};
+
+// Every entry costs 1: the budget is an entry count
+struct UnitWeight 
+{
+    template <typename Key, typename Value>
+    size_t operator()(const Key&, const Value&) const { return 1; }
+};
+
+// Approximate heap footprint of a key or value
+template <typename T>
+size_t payloadBytes(const T&) 
+{
+    return sizeof(T);
+}
+
+inline size_t payloadBytes(const std::string& s) 
+{
+    return sizeof(s) + s.size();
+}
+
+// Entries cost their key and value bytes: the budget is a byte count
+struct ByteWeight 
+{
+    template <typename Key, typename Value>
+    size_t operator()(const Key& key, const Value& value) const 
+    {
+        return payloadBytes(key) + payloadBytes(value);
+    }
+};
+
+// Cache on top of UnorderedMap that never holds more than budget worth of
+// entries (as measured by Weigher), evicting the entries Policy picks.
+// Entries live in a slot array that is reused after evictions, and the map
+// only stores key -> slot, so get/put/erase are O(1) and a steady-state
+// cache does not allocate apart from the map nodes of new keys.
+template <typename Key, typename Value, typename Policy = LruPolicy,
+          typename Weigher = UnitWeight, typename Hash = MapHash<Key>>
+class BoundedCache 
 {
 private:
-    // Node for the hashmap's buckets
-    struct Node 
+    struct Slot 
     {
         Key key;
         Value value;
+        size_t weight;
     };
 
-    // Vector of buckets (each bucket is a list of nodes)
-    std::vector<std::list<Node>> buckets;
-    size_t bucketCount;  // Number of buckets
-    size_t size;         // Total number of elements
-    float loadFactor;    // Maximum load factor
+    UnorderedMap<Key, uint32_t, Hash> index;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    Policy policy;
+    size_t budget;
+    size_t used;
+    size_t hitCount, missCount, evictionCount;
 
-    // Hash function
-    size_t hashFunction(const Key& key) const 
+    void release(uint32_t slot) 
     {
-        return std::hash<Key>{}(key) % bucketCount;
+        policy.onErase(slot);
+        index.erase(slots[slot].key);
+        used -= slots[slot].weight;
+        slots[slot] = Slot{ Key(), Value(), 0 }; // drop the key's and value's memory now
+        freeSlots.push_back(slot);
     }
 
-    // Rehash to increase the bucket count and redistribute elements
-    void rehash() 
+    void evictUntil(size_t limit) 
     {
-        size_t newBucketCount = bucketCount * 2;
-        std::vector<std::list<Node>> newBuckets(newBucketCount);
+        while (used > limit && index.getSize() > 0) 
+        {
+            release(policy.victim());
+            evictionCount++;
+        }
+    }
+
+public:
+    explicit BoundedCache(size_t budgetLimit)
+        : index(16, 0.75), budget(budgetLimit), used(0),
+          hitCount(0), missCount(0), evictionCount(0) {}
+
+    // Value for key, or nullptr on a miss. The pointer is valid until the
+    // next put or erase.
+    Value* get(const Key& key) 
+    {
+        size_t hash = index.hash_of(key); // shared by the index and the policy
+        uint32_t* slot = index.find_hashed(key, hash);
+        if (!slot) 
+        {
+            missCount++;
+            return nullptr;
+        }
+        hitCount++;
+        policy.onHit(*slot, hash);
+        return &slots[*slot].value;
+    }
+
+    // Insert or overwrite key, evicting as needed. Returns false (and stores
+    // nothing) if the entry alone is bigger than the whole budget.
+    bool put(const Key& key, Value value) 
+    {
+        size_t weight = Weigher{}(key, value);
+        if (weight > budget) 
+        {
+            erase(key);
+            return false;
+        }
+
+        // One lookup: either finds the entry or reserves its index node
+        size_t hash = index.hash_of(key);
+        auto found = index.try_emplace_hashed(key, hash, 0u);
+        if (!found.second) 
+        {
+            uint32_t slot = *found.first;
+            used = used - slots[slot].weight + weight;
+            slots[slot].value = std::move(value);
+            slots[slot].weight = weight;
+            policy.onHit(slot, hash);
+            evictUntil(budget);
+            return true;
+        }
 
-        for (const auto& bucket : buckets) 
+        // Make room before the policy learns about the new entry, so the
+        // victim is never the new entry itself. Evictions erase other index
+        // nodes only, and nodes never move, so found.first stays valid.
+        evictUntil(budget - weight);
+
+        uint32_t slot;
+        try 
         {
-            for (const auto& node : bucket) 
+            if (!freeSlots.empty()) 
+            {
+                slot = freeSlots.back();
+                slots[slot] = Slot{ key, std::move(value), weight };
+                freeSlots.pop_back();
+            }
+            else 
             {
-                size_t newIndex = std::hash<Key>{}(node.key) % newBucketCount;
-                newBuckets[newIndex].emplace_back(node);
+                slot = static_cast<uint32_t>(slots.size());
+                slots.push_back(Slot{ key, std::move(value), weight });
             }
         }
+        catch (...) 
+        {
+            index.erase(key); // do not leave the reserved node behind
+            throw;
+        }
+        *found.first = slot;
+        used += weight;
+        policy.onInsert(slot, hash);
+        return true;
+    }
 
-        buckets = std::move(newBuckets);
-        bucketCount = newBucketCount;
+    // Remove key; returns whether it was cached
+    bool erase(const Key& key) 
+    {
+        uint32_t* slot = index.find(key);
+        if (!slot) 
+        {
+            return false;
+        }
+        release(*slot);
+        return true;
     }
 
-public:
-    // Constructor
-    UnorderedMap(size_t initialBucketCount = 8, float maxLoadFactor = 0.75)
-        : bucketCount(initialBucketCount), size(0), loadFactor(maxLoadFactor) {
-        buckets.resize(bucketCount);
+    size_t getSize() const { return index.getSize(); }
+    size_t getWeight() const { return used; }
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    size_t evictions() const { return evictionCount; }
+
+    double hitRatio() const 
+    {
+        size_t lookups = hitCount + missCount;
+        return lookups ? static_cast<double>(hitCount) / lookups : 0.0;
     }
+};
 
-    // Insert or update a key-value pair
-    void insert(const Key& key, const Value& value)
+// Benchmark: insert, hit/miss lookup and erase at fixed load factors. Tables
+// are pre-sized so no rehash happens while a load factor is measured.
+void benchmarkBackends(size_t capacity) 
+{
+    using namespace std::chrono;
+    using Key = unsigned long long;
+
+    std::mt19937_64 rng(5);
+    std::cout << "\nOpen addressing vs chaining, " << capacity << " slots/buckets (ns per op)" << std::endl;
+
+    for (float lf : { 0.5f, 0.6f, 0.7f, 0.8f, 0.9f }) 
     {
-        size_t index = hashFunction(key);
+        size_t n = static_cast<size_t>(capacity * lf);
+        std::vector<Key> keys(n), misses(n);
+        for (auto& k : keys) k = rng();
+        for (auto& k : misses) k = rng();
+        std::vector<Key> probes = keys;
+        std::shuffle(probes.begin(), probes.end(), rng);
 
-        // Check if the key already exists and update it
-        for (auto& node : buckets[index]) 
+        long checksum = 0;
+        auto run = [&](const char* name, auto& map, auto insertFn, auto findFn, auto eraseFn) {
+            auto start = high_resolution_clock::now();
+            for (Key k : keys) insertFn(map, k);
+            auto t1 = high_resolution_clock::now();
+            for (Key k : probes) checksum += findFn(map, k);
+            auto t2 = high_resolution_clock::now();
+            for (Key k : misses) checksum += findFn(map, k);
+            auto t3 = high_resolution_clock::now();
+            for (Key k : probes) eraseFn(map, k);
+            auto t4 = high_resolution_clock::now();
+
+            auto ns = [n](high_resolution_clock::time_point a, high_resolution_clock::time_point b) {
+                return duration_cast<nanoseconds>(b - a).count() / double(n);
+            };
+            std::cout << "  " << name << ": insert " << ns(start, t1) << ", hit " << ns(t1, t2)
+                      << ", miss " << ns(t2, t3) << ", erase " << ns(t3, t4) << std::endl;
+        };
+
+        std::cout << "load factor " << lf << std::endl;
         {
-            if (node.key == key) 
-            {
-                node.value = value;
-                return;
-            }
+            FlatUnorderedMap<Key, int> flat(capacity, 0.95f);
+            run("open addressing  ", flat,
+                [](FlatUnorderedMap<Key, int>& m, Key k) { m.insert(k, 1); },
+                [](FlatUnorderedMap<Key, int>& m, Key k) { return m.find(k) != nullptr; },
+                [](FlatUnorderedMap<Key, int>& m, Key k) { m.erase(k); });
+        }
+        {
+            UnorderedMap<Key, int> chained(capacity, 1.0f);
+            run("chained          ", chained,
+                [](UnorderedMap<Key, int>& m, Key k) { m.insert(k, 1); },
+                [](UnorderedMap<Key, int>& m, Key k) { return m.find(k) != nullptr; },
+                [](UnorderedMap<Key, int>& m, Key k) { m.erase(k); });
+        }
+        {
+            std::unordered_map<Key, int> stdMap;
+            stdMap.max_load_factor(1.0f);
+            stdMap.reserve(capacity);
+            run("std::unordered_map", stdMap,
+                [](std::unordered_map<Key, int>& m, Key k) { m[k] = 1; },
+                [](std::unordered_map<Key, int>& m, Key k) { return m.find(k) != m.end(); },
+                [](std::unordered_map<Key, int>& m, Key k) { m.erase(k); });
         }
+        if (checksum != static_cast<long>(n) * 3) 
+        {
+            std::cout << "  (lookup mismatch!)" << std::endl;
+        }
+    }
+}
 
-        // Insert new node
-        buckets[index].emplace_back(Node{ key, value });
-        size++;
+// Benchmark: latency of every single insert, with the table rehashed all at
+// once versus incrementally. The all-at-once rehash shows up as a handful of
+// inserts that take as long as copying the whole table.
+void benchmarkRehashLatency(size_t n) 
+{
+    using namespace std::chrono;
 
-        // Check load factor and rehash if necessary
-        if (static_cast<float>(size) / bucketCount > loadFactor) 
+    std::mt19937_64 rng(9);
+    std::vector<unsigned long long> keys(n);
+    for (auto& k : keys) k = rng();
+
+    std::cout << "\nInsert latency over " << n << " inserts (ns)" << std::endl;
+    for (size_t step : { 0, 8 }) 
+    {
+        UnorderedMap<unsigned long long, int> map(8, 0.75, step);
+        std::vector<long> latency(n);
+        for (size_t i = 0; i < n; ++i) 
         {
-            rehash();
+            auto start = steady_clock::now();
+            map.insert(keys[i], 1);
+            latency[i] = duration_cast<nanoseconds>(steady_clock::now() - start).count();
         }
+        std::sort(latency.begin(), latency.end());
+
+        std::cout << (step ? "incremental (8 buckets/op)" : "full rehash               ")
+                  << ": p50 " << latency[n / 2] << ", p99 " << latency[n - n / 100 - 1]
+                  << ", p999 " << latency[n - n / 1000 - 1] << ", p9999 " << latency[n - n / 10000 - 1]
+                  << ", max " << latency[n - 1] << std::endl;
     }
+}
 
-    // Find a value by key
-    Value* find(const Key& key) 
+// Allocator that counts what it hands out, so the benchmark below sees
+// every heap allocation made for its string keys without replacing the
+// global operator new
+static size_t keyAllocations = 0;
+
+template <typename T>
+struct CountingAllocator 
+{
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) 
+    {
+        keyAllocations++;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) 
+    {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using CountedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+// Benchmark: key allocations and time per operation for string keys that
+// are too long for the small-string buffer. Keys are CountedStrings hashed
+// like std::string, so transparent lookups work the same way.
+void benchmarkAllocations(size_t n) 
+{
+    using namespace std::chrono;
+    using Map = UnorderedMap<CountedString, int, MapHash<std::string>>;
+
+    std::vector<CountedString> keys(n);
+    std::vector<CountedString> cKeys(n); // storage for the const char* lookups
+    for (size_t i = 0; i < n; ++i) 
+    {
+        keys[i] = ("session-key-" + std::to_string(100000000000ULL + i)).c_str();
+        cKeys[i] = keys[i];
+    }
+
+    std::cout << "\nKey allocations per operation, " << n << " string keys"
+              << " (every inserted key also allocates one list node)" << std::endl;
+    auto measure = [n](const char* name, auto fn) {
+        size_t before = keyAllocations;
+        auto start = high_resolution_clock::now();
+        fn();
+        double ns = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / double(n);
+        std::cout << "  " << name << ": " << double(keyAllocations - before) / n
+                  << " allocs, " << ns << " ns" << std::endl;
+    };
+
+    Map copied;
+    measure("insert(const string&, int)          ", [&]() {
+        for (size_t i = 0; i < n; ++i) copied.insert(keys[i], 1);
+    });
+
+    Map moved;
+    std::vector<CountedString> movable = keys;
+    measure("try_emplace(string&&, int)          ", [&]() {
+        for (size_t i = 0; i < n; ++i) moved.try_emplace(std::move(movable[i]), 1);
+    });
+
+    long hits = 0;
+    measure("find(std::string(const char*)) (old)", [&]() {
+        for (size_t i = 0; i < n; ++i) hits += moved.find(CountedString(cKeys[i].c_str())) != nullptr;
+    });
+    measure("find(const char*)                   ", [&]() {
+        for (size_t i = 0; i < n; ++i) hits += moved.find(cKeys[i].c_str()) != nullptr;
+    });
+    measure("find(std::string_view)              ", [&]() {
+        for (size_t i = 0; i < n; ++i) hits += moved.find(std::string_view(cKeys[i])) != nullptr;
+    });
+    measure("try_emplace on existing key         ", [&]() {
+        for (size_t i = 0; i < n; ++i) hits += !moved.try_emplace(cKeys[i].c_str(), 2).second;
+    });
+
+    if (hits != static_cast<long>(n) * 4) 
+    {
+        std::cout << "  (lookup mismatch!)" << std::endl;
+    }
+}
+
+// Transparent string hasher that counts how often it runs
+struct CountingHash 
+{
+    using is_transparent = void;
+    static size_t calls;
+
+    size_t operator()(std::string_view key) const 
     {
-        size_t index = hashFunction(key);
+        ++calls;
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+size_t CountingHash::calls = 0;
+
+// Benchmark: cost of hashing string keys of 8-256 bytes, and how often the
+// map hashes a key now that nodes cache their hash (growing from 8 buckets
+// used to rehash every key once per doubling)
+void benchmarkHashing(size_t n) 
+{
+    using namespace std::chrono;
 
-        for (auto& node : buckets[index]) 
+    auto nsPerKey = [n](high_resolution_clock::time_point start) {
+        return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / double(n);
+    };
+
+    std::cout << "\nString key hashing, " << n << " keys" << std::endl;
+    for (size_t length : { 8, 16, 32, 64, 128, 256 }) 
+    {
+        std::vector<std::string> keys(n);
+        for (size_t i = 0; i < n; ++i) 
         {
-            if (node.key == key) 
-            {
-                return &node.value;
-            }
+            std::string id = std::to_string(i);
+            keys[i] = std::string(length - id.size(), 'k') + id;
         }
-        return nullptr; // Key not found
+
+        size_t sink = 0;
+        auto start = high_resolution_clock::now();
+        for (const auto& key : keys) sink += std::hash<std::string>{}(key);
+        double hashNs = nsPerKey(start);
+
+        UnorderedMap<std::string, int, CountingHash> map;
+        CountingHash::calls = 0;
+        start = high_resolution_clock::now();
+        for (const auto& key : keys) map.try_emplace(key, 1);
+        double insertNs = nsPerKey(start);
+        double insertHashes = double(CountingHash::calls) / n;
+
+        CountingHash::calls = 0;
+        start = high_resolution_clock::now();
+        for (const auto& key : keys) sink += *map.find(key);
+        double findNs = nsPerKey(start);
+        double findHashes = double(CountingHash::calls) / n;
+
+        std::cout << "  " << length << " B: hash " << hashNs << " ns | insert " << insertNs
+                  << " ns, " << insertHashes << " hashes/key | find " << findNs << " ns, "
+                  << findHashes << " hashes/key" << (sink ? "" : " ") << std::endl;
     }
 
-    // Erase a key-value pair by key
-    void erase(const Key& key) 
-    {
-        size_t index = hashFunction(key);
+    // Bucket index: modulo by a non power of two vs mixing and masking
+    std::vector<size_t> hashes(n);
+    std::mt19937_64 rng(3);
+    for (auto& h : hashes) h = rng();
+    size_t buckets = n | 1, mask = 1;
+    while (mask < n) mask *= 2;
+    size_t sink = 0;
+    auto start = high_resolution_clock::now();
+    for (size_t h : hashes) sink += h % buckets;
+    double moduloNs = nsPerKey(start);
+    start = high_resolution_clock::now();
+    for (size_t h : hashes) sink += mixHash(h) & (mask - 1);
+    double maskNs = nsPerKey(start);
+    std::cout << "  bucket index: modulo " << moduloNs << " ns, mix+mask " << maskNs << " ns"
+              << (sink ? "" : " ") << std::endl;
+}
 
-        for (auto it = buckets[index].begin(); it != buckets[index].end(); ++it) 
+// Benchmark: mixed find/insert throughput from several threads, sharded map
+// versus one UnorderedMap behind a single mutex
+void benchmarkConcurrent(size_t keyCount, size_t totalOps) 
+{
+    using namespace std::chrono;
+
+    std::cout << "\nConcurrent map, " << keyCount << " keys, " << totalOps
+              << " ops per run (M ops/s)" << std::endl;
+
+    for (int readPercent : { 50, 90, 99 }) 
+    {
+        for (unsigned threads : { 1, 2, 4, 8, 16, 32 }) 
         {
-            if (it->key == key) 
-            {
-                buckets[index].erase(it);
-                size--;
-                return;
-            }
+            auto run = [&](auto findFn, auto insertFn) {
+                std::vector<std::thread> workers;
+                auto start = high_resolution_clock::now();
+                for (unsigned t = 0; t < threads; ++t) 
+                {
+                    workers.emplace_back([&, t]() {
+                        std::mt19937_64 rng(t + 1);
+                        for (size_t i = 0; i < totalOps / threads; ++i) 
+                        {
+                            int key = static_cast<int>(rng() % keyCount);
+                            if (static_cast<int>(rng() % 100) < readPercent) findFn(key);
+                            else insertFn(key);
+                        }
+                    });
+                }
+                for (auto& worker : workers) worker.join();
+                return totalOps / (duration_cast<microseconds>(high_resolution_clock::now() - start).count() + 1.0);
+            };
+
+            UnorderedMap<int, int> plain;
+            std::mutex plainMutex;
+            for (size_t k = 0; k < keyCount; ++k) plain.insert(static_cast<int>(k), 0);
+            double locked = run(
+                [&](int key) { std::lock_guard<std::mutex> lock(plainMutex); return plain.find(key) != nullptr; },
+                [&](int key) { std::lock_guard<std::mutex> lock(plainMutex); plain.insert(key, key); });
+
+            ConcurrentUnorderedMap<int, int> sharded;
+            for (size_t k = 0; k < keyCount; ++k) sharded.insert(static_cast<int>(k), 0);
+            double concurrent = run(
+                [&](int key) { return sharded.find(key).has_value(); },
+                [&](int key) { sharded.insert(key, key); });
+
+            std::cout << "  " << readPercent << "% reads, " << threads << " threads: mutex-wrapped "
+                      << locked << ", sharded " << concurrent << std::endl;
         }
     }
+}
 
-    // Access or insert a key-value pair using []
-    Value& operator[](const Key& key) 
+// Zipf(skew) distributed keys in [0, keyCount): key k has weight 1/(k+1)^skew
+std::vector<int> zipfTrace(size_t keyCount, size_t length, double skew, unsigned seed) 
+{
+    std::vector<double> cdf(keyCount);
+    double total = 0;
+    for (size_t k = 0; k < keyCount; ++k) 
+    {
+        total += 1.0 / std::pow(static_cast<double>(k + 1), skew);
+        cdf[k] = total;
+    }
+
+    // Scatter the popular keys over the key space
+    std::vector<int> names(keyCount);
+    for (size_t k = 0; k < keyCount; ++k) names[k] = static_cast<int>(k);
+    std::mt19937_64 rng(seed);
+    std::shuffle(names.begin(), names.end(), rng);
+
+    std::uniform_real_distribution<double> uniform(0.0, total);
+    std::vector<int> trace(length);
+    for (int& key : trace) 
+    {
+        size_t k = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        key = names[std::min(k, keyCount - 1)];
+    }
+    return trace;
+}
+
+// Benchmark: hit ratio and throughput of the eviction policies on Zipfian
+// traces, plus one where every 5th request belongs to a one-off scan
+void benchmarkCache(size_t keyCount) 
+{
+    using namespace std::chrono;
+
+    size_t length = keyCount * 8;
+    struct Trace { const char* name; std::vector<int> keys; };
+    std::vector<Trace> traces;
+    traces.push_back({ "zipf 0.8", zipfTrace(keyCount, length, 0.8, 1) });
+    traces.push_back({ "zipf 0.99", zipfTrace(keyCount, length, 0.99, 2) });
+    traces.push_back({ "zipf 0.99 + scans", zipfTrace(keyCount, length, 0.99, 3) });
+    for (size_t i = 4; i < length; i += 5) 
     {
-        size_t index = hashFunction(key);
+        traces.back().keys[i] = static_cast<int>(keyCount + i); // never repeats
+    }
 
-        // Check if the key already exists
-        for (auto& node : buckets[index]) 
+    std::cout << "\nCache over " << keyCount << " keys, " << length
+              << " requests (hit ratio, M requests/s)" << std::endl;
+
+    for (const Trace& trace : traces) 
+    {
+        for (size_t capacity : { keyCount / 100, keyCount / 10 }) 
         {
-            if (node.key == key) 
-            {
-                return node.value;
-            }
+            auto run = [&](auto& cache) {
+                auto start = high_resolution_clock::now();
+                for (int key : trace.keys) 
+                {
+                    if (!cache.get(key)) cache.put(key, key);
+                }
+                double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+                std::cout << " " << cache.hitRatio() << " @ " << length / seconds / 1e6;
+            };
+
+            std::cout << "  " << trace.name << ", capacity " << capacity << ": LRU";
+            BoundedCache<int, int, LruPolicy> lru(capacity);
+            run(lru);
+            std::cout << " | CLOCK";
+            BoundedCache<int, int, ClockPolicy> clock(capacity);
+            run(clock);
+            std::cout << " | W-TinyLFU";
+            BoundedCache<int, int, TinyLfuPolicy> tinyLfu(capacity);
+            run(tinyLfu);
+            std::cout << std::endl;
         }
+    }
+}
 
-        // Insert a new default value for the key
-        buckets[index].emplace_back(Node{ key, Value{} });
-        size++;
+// Benchmark: restarting with n string keys, by rebuilding an UnorderedMap
+// versus reopening a MappedUnorderedMap file, then lookup throughput of both
+void benchmarkMapped(size_t n) 
+{
+    using namespace std::chrono;
+    const char* path = "unordered_map_bench.db";
+    std::remove(path);
 
-        // Check load factor and rehash if necessary
-        if (static_cast<float>(size) / bucketCount > loadFactor) 
+    std::vector<std::string> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = "user:" + std::to_string(i * 2654435761u);
+
+    std::cout << "\nPersistent map, " << n << " string keys (ms, M lookups/s)" << std::endl;
+
+    auto start = high_resolution_clock::now();
+    {
+        MappedUnorderedMap<int> stored(path);
+        for (size_t i = 0; i < n; ++i) stored.insert(keys[i], static_cast<int>(i));
+        stored.checkpoint();
+    }
+    std::cout << "  build file + checkpoint: "
+              << duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0 << std::endl;
+
+    // Cold start: rebuild in memory (keys already at hand, i.e. the best
+    // case for rebuilding) versus map the file and answer one lookup
+    start = high_resolution_clock::now();
+    UnorderedMap<std::string, int> rebuilt;
+    for (size_t i = 0; i < n; ++i) rebuilt.insert(keys[i], static_cast<int>(i));
+    double rebuildMs = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+
+    start = high_resolution_clock::now();
+    MappedUnorderedMap<int> reopened(path);
+    bool found = reopened.find(keys[n / 2]) != nullptr;
+    double reopenMs = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.0;
+    std::cout << "  cold start: rebuild " << rebuildMs << ", reopen " << reopenMs
+              << (found ? "" : " (lookup failed)") << std::endl;
+
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(9));
+    auto lookups = [&](auto findFn) {
+        auto begin = high_resolution_clock::now();
+        long long sum = 0;
+        for (size_t i : order) sum += *findFn(keys[i]);
+        double seconds = duration_cast<microseconds>(high_resolution_clock::now() - begin).count() / 1e6;
+        return sum >= 0 ? n / seconds / 1e6 : 0.0;
+    };
+    double inMemory = lookups([&](const std::string& key) { return rebuilt.find(key); });
+    double mapped = lookups([&](const std::string& key) { return reopened.find(key); });
+    std::cout << "  lookups: UnorderedMap " << inMemory << ", mapped " << mapped << std::endl;
+
+    std::remove(path);
+}
+
+// Benchmark: find versus find_batch, and insert versus insert_batch, on
+// tables from cache-resident to well beyond the last-level cache
+void benchmarkBatch(size_t maxSize) 
+{
+    using namespace std::chrono;
+    using Key = unsigned long long;
+
+    std::cout << "\nBatched lookups (M ops/s)" << std::endl;
+    std::mt19937_64 rng(11);
+    for (size_t n : { maxSize / 64, maxSize / 8, maxSize }) 
+    {
+        std::vector<std::pair<Key, int>> items(n);
+        for (size_t i = 0; i < n; ++i) items[i] = { rng(), static_cast<int>(i) };
+        std::vector<Key> probes(n);
+        for (size_t i = 0; i < n; ++i) probes[i] = items[rng() % n].first;
+
+        auto rate = [n](high_resolution_clock::time_point a, high_resolution_clock::time_point b) {
+            return n / (duration_cast<microseconds>(b - a).count() + 1.0);
+        };
+
+        auto t0 = high_resolution_clock::now();
+        UnorderedMap<Key, int> single(n);
+        for (const auto& item : items) single.insert(item.first, item.second);
+        auto t1 = high_resolution_clock::now();
+        UnorderedMap<Key, int> batched(n);
+        batched.insert_batch(items);
+        auto t2 = high_resolution_clock::now();
+
+        // Like a join: look up a block of keys, then consume the results
+        // while they are still cached
+        long long sum = 0;
+        auto t3 = high_resolution_clock::now();
+        for (Key k : probes) sum += *single.find(k);
+        auto t4 = high_resolution_clock::now();
+        int* out[256];
+        for (size_t start = 0; start < n; start += 256) 
         {
-            rehash();
+            size_t count = std::min<size_t>(256, n - start);
+            batched.find_batch(&probes[start], count, out);
+            for (size_t i = 0; i < count; ++i) sum -= *out[i];
         }
+        auto t5 = high_resolution_clock::now();
 
-        return buckets[index].back().value;
+        std::cout << "  " << n << " keys: insert " << rate(t0, t1) << ", insert_batch " << rate(t1, t2)
+                  << " | find " << rate(t3, t4) << ", find_batch " << rate(t4, t5)
+                  << (sum == 0 ? "" : " (mismatch!)") << std::endl;
     }
+}
 
-    // Get the number of elements
-    size_t getSize() const 
+// Deliberately poor hash: every 32 consecutive keys get the same value
+struct CoarseHash 
+{
+    size_t operator()(unsigned long long key) const { return std::hash<unsigned long long>{}(key / 32); }
+};
+
+// Benchmark: what stats() reports for a good and a poor hash, and what
+// instrumentation costs a lookup
+void benchmarkStats(size_t n) 
+{
+    using namespace std::chrono;
+    using Key = unsigned long long;
+
+    std::vector<Key> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = i;
+    std::vector<Key> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(4));
+
+    std::cout << "\nStatistics, " << n << " keys" << std::endl;
+    auto lookups = [&](auto& map) {
+        long long sum = 0;
+        auto start = high_resolution_clock::now();
+        for (Key k : probes) sum += *map.find(k);
+        double ns = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / double(n);
+        return sum > 0 ? ns : -1.0;
+    };
+
+    UnorderedMap<Key, int> plain;
+    UnorderedMap<Key, int, MapHash<Key>, true> good;
+    UnorderedMap<Key, int, CoarseHash, true> poor;
+    for (Key k : keys) 
     {
-        return size;
+        plain.insert(k, 1);
+        good.insert(k, 1);
+        poor.insert(k, 1);
     }
-};
+    std::cout << "  find: plain " << lookups(plain) << " ns, instrumented " << lookups(good) << " ns" << std::endl;
+    lookups(poor);
+    dumpStats(std::cout, "good_hash", good.stats());
+    dumpStats(std::cout, "poor_hash", poor.stats());
+}
+
+// Benchmark: perfect hash map versus the chained map for a fixed key set,
+// build time and lookups of present and absent keys
+void benchmarkPerfectHash(size_t maxKeys) 
+{
+    using namespace std::chrono;
+
+    std::cout << "\nPerfect hashing (build ms, ns per lookup)" << std::endl;
+    for (size_t n : { size_t(64), size_t(4096), maxKeys }) 
+    {
+        std::vector<std::pair<std::string, int>> entries(n);
+        std::vector<std::string> absent(n);
+        for (size_t i = 0; i < n; ++i) 
+        {
+            entries[i] = { "x-header-" + std::to_string(i * 7919), static_cast<int>(i) };
+            absent[i] = "x-missing-" + std::to_string(i);
+        }
+        std::vector<std::string_view> probes;
+        for (size_t round = 0; round < std::max<size_t>(1, 1000000 / n); ++round) 
+        {
+            for (const auto& entry : entries) probes.push_back(entry.first);
+        }
+        std::shuffle(probes.begin(), probes.end(), std::mt19937(6));
+
+        auto ms = [](high_resolution_clock::time_point a, high_resolution_clock::time_point b) {
+            return duration_cast<microseconds>(b - a).count() / 1000.0;
+        };
+        auto lookups = [&](auto findFn) {
+            long long sum = 0;
+            auto start = high_resolution_clock::now();
+            for (std::string_view key : probes) sum += *findFn(key);
+            auto middle = high_resolution_clock::now();
+            for (const std::string& key : absent) sum += findFn(key) != nullptr;
+            auto end = high_resolution_clock::now();
+            double hit = duration_cast<nanoseconds>(middle - start).count() / double(probes.size());
+            double miss = duration_cast<nanoseconds>(end - middle).count() / double(n);
+            return std::make_pair(sum >= 0 ? hit : -1.0, miss);
+        };
+
+        auto t0 = high_resolution_clock::now();
+        UnorderedMap<std::string, int> chained;
+        for (const auto& entry : entries) chained.insert(entry.first, entry.second);
+        auto t1 = high_resolution_clock::now();
+        PerfectHashMap<int> perfect(entries);
+        auto t2 = high_resolution_clock::now();
 
-int main() 
+        auto chainedTimes = lookups([&](std::string_view key) { return std::as_const(chained).find(key); });
+        auto perfectTimes = lookups([&](std::string_view key) { return perfect.find(key); });
+        std::cout << "  " << n << " keys: build chained " << ms(t0, t1) << ", perfect " << ms(t1, t2)
+                  << " | hit chained " << chainedTimes.first << ", perfect " << perfectTimes.first
+                  << " | miss chained " << chainedTimes.second << ", perfect " << perfectTimes.second << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) 
 {
     UnorderedMap<std::string, int> umap;
 
@@ -153,7 +2885,7 @@ int main()
     umap.insert("Bob", 25);
     umap.insert("Charlie", 35);
 
-    // Access using find
+    // Access using find ("Bob" is looked up without building a std::string)
     if (auto val = umap.find("Bob")) 
     {
         std::cout << "Bob's age: " << *val << std::endl;
@@ -176,6 +2908,114 @@ int main()
     umap.erase("David");
     
     std::cout << "Size: " << umap.getSize() << std::endl;
+
+    // Same API on the open-addressing table
+    FlatUnorderedMap<std::string, int> flat;
+    flat.insert("Alice", 30);
+    flat.insert("Bob", 25);
+    flat["David"] = 40;
+    flat.erase("Alice");
+    std::cout << "Flat: Bob's age: " << *flat.find("Bob") << ", David's age: " << flat["David"]
+              << ", size: " << flat.getSize() << std::endl;
+
+    // Incremental rehashing: growing the table never stops the world
+    UnorderedMap<int, int> incremental(8, 0.75, 4);
+    for (int i = 0; i < 100; ++i) 
+    {
+        incremental.insert(i, i * i);
+    }
+    std::cout << "Incremental: 9 squared is " << *incremental.find(9)
+              << ", still rehashing: " << (incremental.isRehashing() ? "yes" : "no") << std::endl;
+
+    // In-place construction: the key is moved in, the value built from its arguments
+    std::string name = "Eve";
+    umap.try_emplace(std::move(name), 28);
+    umap.insert_or_assign("Eve", 29);
+    std::cout << "Eve's age: " << *umap.find(std::string_view("Eve")) << std::endl;
+
+    // Sharded map shared by several threads
+    ConcurrentUnorderedMap<std::string, int> counters;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) 
+    {
+        workers.emplace_back([&counters]() {
+            for (int i = 0; i < 1000; ++i) 
+            {
+                counters.compute_if_absent("hits", []() { return 0; });
+                counters.update("hits", [](int& value) { value++; });
+            }
+        });
+    }
+    for (auto& worker : workers) 
+    {
+        worker.join();
+    }
+    std::cout << "Concurrent hits: " << *counters.find("hits") << std::endl;
+
+    // Cache holding at most two entries
+    BoundedCache<std::string, int> recent(2);
+    recent.put("Alice", 30);
+    recent.put("Bob", 25);
+    recent.get("Alice");
+    recent.put("Charlie", 35); // evicts Bob, the least recently used
+    std::cout << "Cache: Bob cached: " << (recent.get("Bob") ? "yes" : "no")
+              << ", hits: " << recent.hits() << ", misses: " << recent.misses()
+              << ", evictions: " << recent.evictions() << std::endl;
+
+    // Map stored in a file: write it, close it and read it back
+    {
+        MappedUnorderedMap<int> stored("unordered_map_demo.db");
+        stored.insert("Alice", 30);
+        stored.insert("Bob", 25);
+        stored.checkpoint();
+    }
+    {
+        MappedUnorderedMap<int> reopened("unordered_map_demo.db");
+        std::cout << "Mapped: Bob's age: " << *reopened.find("Bob")
+                  << ", size: " << reopened.getSize() << std::endl;
+    }
+    std::remove("unordered_map_demo.db");
+
+    // Fixed key sets: built at compile time, or once at startup
+    PerfectHashMap<int> ages({ { "Alice", 30 }, { "Bob", 25 }, { "Charlie", 35 } });
+    std::cout << "Perfect hash: opcode of add: " << *opcodeTable.find("add")
+              << ", Charlie's age: " << *ages.find("Charlie") << std::endl;
+
+    // Instrumented map: every insert looks its key up first, then 100 finds
+    // from two threads at once; growing from 8 buckets to 256 takes 5 rehashes
+    UnorderedMap<int, int, MapHash<int>, true> counted(8);
+    for (int i = 0; i < 100; ++i) 
+    {
+        counted.insert(i, i);
+    }
+    const auto& reader = counted;
+    std::thread other([&reader]() {
+        for (int i = 0; i < 50; ++i) reader.find(i);
+    });
+    for (int i = 50; i < 100; ++i) 
+    {
+        reader.find(i);
+    }
+    other.join();
+    HashTableStats counts = counted.stats();
+    std::cout << "Stats: " << counts.lookups << " lookups, " << counts.rehashes << " rehashes"
+              << (counts.lookups == 200 && counts.rehashes == 5 ? "" : " (counter mismatch!)") << std::endl;
+
+    // Run "./unordered_map bench [slots]" for the benchmarks
+    if (argc > 1 && std::string(argv[1]) == "bench") 
+    {
+        size_t slots = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : (1 << 20);
+        benchmarkBackends(slots);
+        benchmarkRehashLatency(slots * 2);
+        benchmarkAllocations(slots);
+        benchmarkHashing(slots / 4);
+        benchmarkConcurrent(slots / 4, slots);
+        benchmarkCache(slots / 4);
+        benchmarkMapped(slots);
+        benchmarkBatch(slots * 8);
+        benchmarkStats(slots);
+        benchmarkPerfectHash(slots / 4);
+    }
     return 0;
 }
 
@@ -197,3 +3037,37 @@ int main()
 //
 //Scalability: Resizes automatically to maintain performance as the number of elements grows.
 //Default Values: Uses Value{} as the default when accessing keys that do not exist.
+//
+//FlatUnorderedMap: same API with open addressing (SwissTable-style control
+//bytes, 16-slot SSE2 group probing), no per-entry allocation.
+//
+//Incremental Rehash (optional): keeps the old table alongside the new one and
+//moves a few buckets per operation, so no single insert pays for the resize.
+//No Needless Copies: try_emplace/insert_or_assign/emplace forward their
+//arguments, rehash splices list nodes, and std::string maps accept
+//const char*/std::string_view lookups without building a temporary key.
+//Cached Hashes: every node stores its mixed hash, so rehashing never hashes a
+//key again and keys are only compared when hashes match; bucket counts are
+//powers of two, so the index is a mask instead of a modulo.
+//
+//ConcurrentUnorderedMap: N UnorderedMap shards, each behind its own
+//shared_mutex, with atomic compute_if_absent/update; shards resize
+//independently, so growing never blocks the whole map.
+//
+//BoundedCache: UnorderedMap-backed cache with an entry or byte budget and a
+//pluggable eviction policy (LRU, CLOCK or W-TinyLFU admission), O(1)
+//get/put/erase and hit/miss/eviction counters.
+//
+//MappedUnorderedMap: string -> trivially copyable value table kept in an
+//mmap'ed file using offsets instead of pointers; reopening is zero-copy and
+//checkpoint() msyncs the file.
+//Batched Lookups: find_batch/insert_batch hash keys and prefetch their
+//buckets and first nodes 8-16 keys ahead of probing, overlapping cache misses.
+//Statistics (opt-in): UnorderedMap<Key, Value, Hash, true> counts lookups,
+//collisions and rehash time; stats() adds bucket occupancy, chain lengths and
+//memory, and dumpStats() prints them for a metrics exporter. Disabled, the
+//counters are an empty base class (checked by static_assert).
+//
+//Perfect Hashing: StaticPerfectHashMap is built by the compiler from a
+//constexpr key list (CHD-style hash and displace), PerfectHashMap at startup;
+//lookups are one hash, one seed and one key compare.
@@ -1,23 +1,59 @@
 /* vector implementation */
 #include<iostream>
 #include<string>
+#include<chrono>
+#include<stdexcept>
+#include<type_traits>
+#include<utility>
 using namespace std ;
-template<class T> class vector
+
+// Base of everything that can appear in an element-wise expression: a
+// vector, a scalar, or a node combining two of them. E provides
+// GetSize() and operator[](int); nothing is computed until the whole
+// expression is assigned to a vector or reduced, so a + b * c runs as a
+// single loop with no temporaries.
+template<class E> struct VectorExpression
+{
+    const E& self() const { return static_cast<const E&>(*this) ; }
+};
+
+long vectorAllocations = 0 ;    // buffers allocated by every vector<T>, for the benchmark
+
+template<class T> class vector : public VectorExpression<vector<T>>
 {
     private:
         T *data;
         int size;
         int capacity ;
+        static T* allocate(int count);
     public:
+        using value_type = T ;
+        static constexpr bool isLeaf = true ;   // held by reference inside expressions
+
         vector();
+        explicit vector(int count , T value = T());
+        vector(const vector& other);
+        vector(vector&& other) noexcept;
+        template<class E> vector(const VectorExpression<E>& expr);
+        ~vector();
+        vector& operator=(vector other);
+        template<class E> vector& operator=(const VectorExpression<E>& expr);
+        T& operator[](int index) { return data[index] ; }
+        const T& operator[](int index) const { return data[index] ; }
         void push_back(T);
         void pop_back();
         void insert(T data , int index) ;
-        int GetSize() ;
-        int GetCapacity() ;
+        int GetSize() const ;
+        int GetCapacity() const ;
         void print();
 };
 
+template<class T> T* vector<T>::allocate(int count)
+{
+    vectorAllocations++ ;
+    return new T[count] ;
+}
+
 template<class T> void vector<T>::print()
 {
     if(size == 0)
@@ -33,22 +69,106 @@ template<class T> void vector<T>::print()
 }
 template<class T> vector<T>::vector()
 {
-    data = new T[1] ;
+    data = allocate(1) ;
     capacity = 1 ;
     size = 0 ;
 }
 
+template<class T> vector<T>::vector(int count , T value)
+{
+    capacity = count > 0 ? count : 1 ;
+    data = allocate(capacity) ;
+    size = count ;
+    for(int loop=0;loop<size;loop++)
+    {
+        data[loop] = value ;
+    }
+}
+
+template<class T> vector<T>::vector(const vector& other)
+{
+    capacity = other.size > 0 ? other.size : 1 ;
+    data = allocate(capacity) ;
+    size = other.size ;
+    for(int loop=0;loop<size;loop++)
+    {
+        data[loop] = other.data[loop] ;
+    }
+}
+
+template<class T> vector<T>::vector(vector&& other) noexcept
+{
+    data = other.data ;
+    size = other.size ;
+    capacity = other.capacity ;
+    other.data = nullptr ;
+    other.size = 0 ;
+    other.capacity = 0 ;
+}
+
+// Evaluate an expression into a new vector: one pass, one allocation
+template<class T> template<class E> vector<T>::vector(const VectorExpression<E>& expr)
+{
+    const E& source = expr.self() ;
+    int count = source.GetSize() ;
+    capacity = count > 0 ? count : 1 ;
+    T *out = allocate(capacity) ;
+#pragma GCC ivdep
+    for(int loop=0;loop<count;loop++)
+    {
+        out[loop] = source[loop] ;
+    }
+    data = out ;
+    size = count ;
+}
+
+template<class T> vector<T>::~vector()
+{
+    delete []data ;
+}
+
+// Copy and move assignment both go through the by-value parameter
+template<class T> vector<T>& vector<T>::operator=(vector other)
+{
+    swap(data , other.data) ;
+    swap(size , other.size) ;
+    swap(capacity , other.capacity) ;
+    return *this ;
+}
+
+// Same size: overwrite in place (a = a + b is fine, every element only
+// reads its own index, which is also what lets the loop be vectorized
+// without a runtime overlap check). Otherwise build a new buffer first,
+// since the expression may still be reading this one.
+template<class T> template<class E> vector<T>& vector<T>::operator=(const VectorExpression<E>& expr)
+{
+    const E& source = expr.self() ;
+    int count = source.GetSize() ;
+    if(count != size)
+    {
+        return *this = vector<T>(source) ;
+    }
+    T *out = data ;
+#pragma GCC ivdep
+    for(int loop=0;loop<count;loop++)
+    {
+        out[loop] = source[loop] ;
+    }
+    return *this ;
+}
+
 template<class T> void vector<T>::push_back(T elem)
 {
     if(size == capacity)
     {
-        T *temp_elem = new T[2*capacity] ;
+        int grown = capacity > 0 ? 2*capacity : 1 ;
+        T *temp_elem = allocate(grown) ;
         for(int loop=0;loop<size;loop++)
         {
             temp_elem[loop] = data[loop] ;
         }
         delete []data ;
-        capacity *=  2;
+        capacity = grown ;
         data = temp_elem ;
     }
     data[size] = elem ;
@@ -65,17 +185,306 @@ template<class T> void vector<T>::pop_back()
     cout<<data[--size]<<"   Popped back\n";
 }
 
-template<class T> int vector<T>::GetSize()
+template<class T> int vector<T>::GetSize() const
 {
-    return size ; 
+    return size ;
 }
 
-template<class T> int vector<T>::GetCapacity()
+template<class T> int vector<T>::GetCapacity() const
 {
     return capacity ;
 }
 
-int main()
+// Vectors are held by reference; scalars and inner nodes are small and
+// held by value, so an expression can outlive the statement building it
+// as long as its vectors do
+template<class E> using ExpressionOperand = conditional_t<E::isLeaf , const E& , const E> ;
+
+// A scalar operand, the same value at every index. Its size of -1 lets
+// the node it is part of take the size of the other operand.
+template<class T> struct ScalarExpression : VectorExpression<ScalarExpression<T>>
+{
+    using value_type = T ;
+    static constexpr bool isLeaf = false ;
+    T value ;
+
+    explicit ScalarExpression(T scalar) : value(scalar) {}
+    int GetSize() const { return -1 ; }
+    T operator[](int) const { return value ; }
+};
+
+template<class E , class Op> struct UnaryExpression : VectorExpression<UnaryExpression<E , Op>>
+{
+    using value_type = decltype(Op()(declval<typename E::value_type>())) ;
+    static constexpr bool isLeaf = false ;
+    ExpressionOperand<E> operand ;
+
+    explicit UnaryExpression(const E& e) : operand(e) {}
+    int GetSize() const { return operand.GetSize() ; }
+    value_type operator[](int index) const { return Op()(operand[index]) ; }
+};
+
+// Op applied element by element; the sizes are checked once here rather
+// than on every access
+template<class L , class R , class Op> struct BinaryExpression : VectorExpression<BinaryExpression<L , R , Op>>
+{
+    using value_type = decltype(Op()(declval<typename L::value_type>() , declval<typename R::value_type>())) ;
+    static constexpr bool isLeaf = false ;
+    ExpressionOperand<L> left ;
+    ExpressionOperand<R> right ;
+    int size ;
+
+    BinaryExpression(const L& l , const R& r) : left(l) , right(r) , size(l.GetSize() < 0 ? r.GetSize() : l.GetSize())
+    {
+        if(l.GetSize() >= 0 && r.GetSize() >= 0 && l.GetSize() != r.GetSize())
+        {
+            throw invalid_argument("vector expression: operand sizes differ") ;
+        }
+    }
+    int GetSize() const { return size ; }
+    value_type operator[](int index) const { return Op()(left[index] , right[index]) ; }
+};
+
+// Element operations used by the nodes (<functional> is not included: it
+// brings in std::vector, which clashes with this file's vector)
+#define VECTOR_ELEMENT_BINARY(Name , symbol)                                      \
+struct Name                                                                       \
+{                                                                                 \
+    template<class A , class B> auto operator()(const A& a , const B& b) const    \
+    {                                                                             \
+        return a symbol b ;                                                       \
+    }                                                                             \
+};
+
+VECTOR_ELEMENT_BINARY(AddOp , +)
+VECTOR_ELEMENT_BINARY(SubtractOp , -)
+VECTOR_ELEMENT_BINARY(MultiplyOp , *)
+VECTOR_ELEMENT_BINARY(DivideOp , /)
+VECTOR_ELEMENT_BINARY(LessOp , <)
+VECTOR_ELEMENT_BINARY(GreaterOp , >)
+VECTOR_ELEMENT_BINARY(LessEqualOp , <=)
+VECTOR_ELEMENT_BINARY(GreaterEqualOp , >=)
+VECTOR_ELEMENT_BINARY(EqualOp , ==)
+VECTOR_ELEMENT_BINARY(NotEqualOp , !=)
+VECTOR_ELEMENT_BINARY(AndOp , &&)
+VECTOR_ELEMENT_BINARY(OrOp , ||)
+
+#undef VECTOR_ELEMENT_BINARY
+
+struct NegateOp
+{
+    template<class A> auto operator()(const A& a) const { return -a ; }
+};
+
+struct NotOp
+{
+    template<class A> bool operator()(const A& a) const { return !a ; }
+};
+
+// Each operator takes two expressions, or an expression and an arithmetic
+// scalar on either side
+#define VECTOR_EXPRESSION_OPERATOR(symbol , Op)                                                         \
+template<class L , class R>                                                                             \
+BinaryExpression<L , R , Op> operator symbol(const VectorExpression<L>& l , const VectorExpression<R>& r) \
+{                                                                                                       \
+    return BinaryExpression<L , R , Op>(l.self() , r.self()) ;                                          \
+}                                                                                                       \
+template<class L , class S , class = enable_if_t<is_arithmetic<S>::value>>                               \
+BinaryExpression<L , ScalarExpression<S> , Op> operator symbol(const VectorExpression<L>& l , S s)       \
+{                                                                                                       \
+    return BinaryExpression<L , ScalarExpression<S> , Op>(l.self() , ScalarExpression<S>(s)) ;          \
+}                                                                                                       \
+template<class S , class R , class = enable_if_t<is_arithmetic<S>::value>>                               \
+BinaryExpression<ScalarExpression<S> , R , Op> operator symbol(S s , const VectorExpression<R>& r)       \
+{                                                                                                       \
+    return BinaryExpression<ScalarExpression<S> , R , Op>(ScalarExpression<S>(s) , r.self()) ;          \
+}
+
+VECTOR_EXPRESSION_OPERATOR(+ , AddOp)
+VECTOR_EXPRESSION_OPERATOR(- , SubtractOp)
+VECTOR_EXPRESSION_OPERATOR(* , MultiplyOp)
+VECTOR_EXPRESSION_OPERATOR(/ , DivideOp)
+VECTOR_EXPRESSION_OPERATOR(< , LessOp)
+VECTOR_EXPRESSION_OPERATOR(> , GreaterOp)
+VECTOR_EXPRESSION_OPERATOR(<= , LessEqualOp)
+VECTOR_EXPRESSION_OPERATOR(>= , GreaterEqualOp)
+VECTOR_EXPRESSION_OPERATOR(== , EqualOp)
+VECTOR_EXPRESSION_OPERATOR(!= , NotEqualOp)
+VECTOR_EXPRESSION_OPERATOR(&& , AndOp)
+VECTOR_EXPRESSION_OPERATOR(|| , OrOp)
+
+#undef VECTOR_EXPRESSION_OPERATOR
+
+template<class E> UnaryExpression<E , NegateOp> operator-(const VectorExpression<E>& e)
+{
+    return UnaryExpression<E , NegateOp>(e.self()) ;
+}
+
+template<class E> UnaryExpression<E , NotOp> operator!(const VectorExpression<E>& e)
+{
+    return UnaryExpression<E , NotOp>(e.self()) ;
+}
+
+// Reductions evaluate the expression while consuming it. sum keeps eight
+// partial sums so the loop is not one long dependency chain and can be
+// vectorized without reordering a single accumulator.
+template<class E> typename E::value_type sum(const VectorExpression<E>& expr)
+{
+    using T = typename E::value_type ;
+    const E& source = expr.self() ;
+    int count = source.GetSize() ;
+    T partial[8] = {} ;
+    int loop = 0 ;
+    for(;loop+8<=count;loop+=8)
+    {
+        for(int lane=0;lane<8;lane++)
+        {
+            partial[lane] += source[loop+lane] ;
+        }
+    }
+    T total = T() ;
+    for(;loop<count;loop++)
+    {
+        total += source[loop] ;
+    }
+    for(int lane=0;lane<8;lane++)
+    {
+        total += partial[lane] ;
+    }
+    return total ;
+}
+
+// max and min follow Operations<T>::max1/min1; they need a non-empty vector
+template<class E> typename E::value_type max(const VectorExpression<E>& expr)
+{
+    const E& source = expr.self() ;
+    int count = source.GetSize() ;
+    if(count <= 0)
+    {
+        throw invalid_argument("max of an empty vector") ;
+    }
+    typename E::value_type result = source[0] ;
+    for(int loop=1;loop<count;loop++)
+    {
+        typename E::value_type value = source[loop] ;
+        result = (value>result)?value:result ;
+    }
+    return result ;
+}
+
+template<class E> typename E::value_type min(const VectorExpression<E>& expr)
+{
+    const E& source = expr.self() ;
+    int count = source.GetSize() ;
+    if(count <= 0)
+    {
+        throw invalid_argument("min of an empty vector") ;
+    }
+    typename E::value_type result = source[0] ;
+    for(int loop=1;loop<count;loop++)
+    {
+        typename E::value_type value = source[loop] ;
+        result = (value<result)?value:result ;
+    }
+    return result ;
+}
+
+// Number of elements that are true, e.g. count(a < b * 2)
+template<class E> int count(const VectorExpression<E>& expr)
+{
+    const E& source = expr.self() ;
+    int total = 0 ;
+    int size = source.GetSize() ;
+    for(int loop=0;loop<size;loop++)
+    {
+        total += source[loop] ? 1 : 0 ;
+    }
+    return total ;
+}
+
+template<class E> bool all(const VectorExpression<E>& expr)
+{
+    return count(expr) == expr.self().GetSize() ;
+}
+
+template<class E> bool any(const VectorExpression<E>& expr)
+{
+    return count(expr) > 0 ;
+}
+
+// Operations<T>::IsEqual for whole vectors (a == b alone is element-wise)
+template<class L , class R> bool equal(const VectorExpression<L>& l , const VectorExpression<R>& r)
+{
+    return l.self().GetSize() == r.self().GetSize() && all(l == r) ;
+}
+
+// What the operators would cost if each returned a vector: every step
+// allocates and writes a full temporary that the next step reads back
+template<class A , class B , class Op> auto materialize(const vector<A>& l , const vector<B>& r , Op op)
+{
+    vector<decltype(op(l[0] , r[0]))> result(l.GetSize()) ;
+    for(int loop=0;loop<l.GetSize();loop++)
+    {
+        result[loop] = op(l[loop] , r[loop]) ;
+    }
+    return result ;
+}
+
+// Time per pass, bytes of vector data read and written per pass, and
+// buffers allocated per pass, for each way of computing one expression
+template<class Fn> void benchmarkPass(const char* name , int n , int rounds , double bytesPerElement , Fn pass)
+{
+    long allocationsBefore = vectorAllocations ;
+    auto start = chrono::steady_clock::now() ;
+    for(int round=0;round<rounds;round++)
+    {
+        pass() ;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / rounds ;
+    double megabytes = bytesPerElement * n / 1e6 ;
+    cout<<"  "<<name<<": "<<seconds*1e3<<" ms, "<<megabytes<<" MB moved ("
+        <<megabytes/1e3/seconds<<" GB/s), "<<double(vectorAllocations - allocationsBefore)/rounds
+        <<" allocations\n" ;
+}
+
+void benchmarkExpressions(int n)
+{
+    vector<float> a(n) , b(n) , c(n) , result(n) ;
+    for(int loop=0;loop<n;loop++)
+    {
+        a[loop] = float(loop % 1000) ;
+        b[loop] = float(loop % 77) * 0.5f ;
+        c[loop] = float(loop % 13) + 1.0f ;
+    }
+    const int rounds = 20 ;
+    const double f = sizeof(float) ;
+    volatile double sink = 0 ;
+
+    cout<<"\nExpression templates, "<<n<<" floats per vector\n" ;
+    cout<<"result = a + b * c\n" ;
+    benchmarkPass("temporaries" , n , rounds , 6*f , [&]() {
+        vector<float> product = materialize(b , c , MultiplyOp()) ;
+        result = materialize(a , product , AddOp()) ;
+    }) ;
+    benchmarkPass("fused" , n , rounds , 4*f , [&]() { result = a + b * c ; }) ;
+
+    cout<<"count(a < b * c)\n" ;
+    benchmarkPass("temporaries" , n , rounds , 5*f + 2 , [&]() {
+        vector<float> product = materialize(b , c , MultiplyOp()) ;
+        vector<bool> mask = materialize(a , product , LessOp()) ;
+        sink = sink + count(mask) ;
+    }) ;
+    benchmarkPass("fused" , n , rounds , 3*f , [&]() { sink = sink + count(a < b * c) ; }) ;
+
+    cout<<"sum(a * b)\n" ;
+    benchmarkPass("temporaries" , n , rounds , 4*f , [&]() {
+        vector<float> product = materialize(a , b , MultiplyOp()) ;
+        sink = sink + sum(product) ;
+    }) ;
+    benchmarkPass("fused" , n , rounds , 2*f , [&]() { sink = sink + sum(a * b) ; }) ;
+}
+
+int main(int argc , char* argv[])
 {
     vector<string> vec1;
     vec1.push_back("gaurav");
@@ -87,5 +496,24 @@ int main()
     vec1.print();
     cout<<"vector size is "<<vec1.GetSize()<<"\n" ;
     cout<<"vector capacity is "<<vec1.GetCapacity()<<"\n" ;
+
+    // Element-wise arithmetic, comparisons and reductions, each one loop
+    vector<float> a , b ;
+    for(int loop=1;loop<=5;loop++)
+    {
+        a.push_back(float(loop)) ;
+        b.push_back(float(6 - loop)) ;
+    }
+    vector<float> c = a + b * 2.0f ;
+    c.print() ;
+    cout<<"sum(a * b) = "<<sum(a * b)<<", max(a - b) = "<<max(a - b)<<", count(a > b) = "<<count(a > b)
+        <<", equal(a, b) = "<<equal(a , b)<<", equal(c - 2 * b, a) = "<<equal(c - 2 * b , a)<<"\n" ;
+
+    // Run "./vector bench [n]" to compare against materialized temporaries
+    // (build with -O3: GCC 12 at -O2 leaves loops of unknown length scalar)
+    if(argc > 1 && string(argv[1]) == "bench")
+    {
+        benchmarkExpressions(argc > 2 ? stoi(argv[2]) : (1 << 22)) ;
+    }
     return 0 ;
 }